@@ -0,0 +1,90 @@
+#!/bin/bash
+#
+# Benchmark sweep over instance classes x N x engines (see generate.cpp)
+#
+# Every configuration is solved on BENCH_REPS seeded instances and the
+# solve time (initialization + search, from --stats) is summarized as
+# median, p99 and instances per second in $BENCH_OUT.csv / .json
+#
+# Environment: BENCH_N, BENCH_REPS, BENCH_CLASSES, BENCH_OUT, and
+# BENCH_STORAGE=file (solve binary matrices with --matrix, through a
+# row cache of BENCH_ROW_CACHE MB) instead of text on standard input,
+# and BENCH_ARGS, extra solver options (e.g. BENCH_ARGS=--candidates=8)
+#
+# "auto" is swept next to the engines to show what it picks, and
+# $OUT.tune is a tuning table for hungarian.exe --tune: for each N of
+# the sweep, the engine with the least total median over the classes,
+# separately for the classes whose rows share their argmin columns
+# (diversity < 0.25, see choose_engine in hungarian.cpp)
+#
+
+NS=${BENCH_N:-"10 20 50 100 200 500 1000 2000"}
+REPS=${BENCH_REPS:-5}
+CLASSES=${BENCH_CLASSES:-"uniform:100 uniform:10000 uniform:1000000 machol-wien geometric:1000 few-values:1000 long-path"}
+OUT=${BENCH_OUT:-bench}
+STORAGE=${BENCH_STORAGE:-memory}
+ROW_CACHE=${BENCH_ROW_CACHE:-1024}
+ARGS=${BENCH_ARGS:-}
+
+engines() {
+  if [ "$1" -le 64 ]; then echo "fixed dense packed pruned auto"; else echo "dense packed pruned auto"; fi
+}
+
+tmp=$(mktemp -d)
+trap 'rm -rf "$tmp"' EXIT
+
+echo "class,range,n,engine,reps,median_s,p99_s,instances_per_s" > "$OUT.csv"
+
+for cls in $CLASSES; do
+  name=${cls%%:*}
+  range=${cls#*:}
+  [ "$range" = "$cls" ] && range=""
+  for n in $NS; do
+    for e in $(engines $n); do rm -f "$tmp/times.$e"; done
+    for seed in $(seq 1 $REPS); do
+      if [ "$STORAGE" = file ]; then
+        ./generate.exe --binary $name $n $seed $range > "$tmp/in" || exit 1
+        input=(--matrix="$tmp/in" --row-cache=$ROW_CACHE)
+      else
+        ./generate.exe $name $n $seed $range > "$tmp/in" || exit 1
+        input=()
+      fi
+      for e in $(engines $n); do
+        ./hungarian.exe --engine=$e --stats $ARGS "${input[@]}" < "$tmp/in" 2> "$tmp/stats" > /dev/null || exit 1
+        sed -E 's/.*"initialization":([^,]*),"search":([^,]*),.*/\1 \2/' "$tmp/stats" |
+          awk '{ printf "%.9f\n", $1+$2 }' >> "$tmp/times.$e"
+        [ $e = auto ] && sed -nE "s/.*\"diversity\":([^,}]*).*/$name,$range,$n,\1/p" "$tmp/stats" >> "$tmp/features"
+      done
+    done
+    for e in $(engines $n); do
+      sort -g "$tmp/times.$e" | awk -v cls=$name -v range=$range -v n=$n -v e=$e '
+        { t[NR] = $1; sum += $1 }
+        END {
+          med = t[int((NR+1)/2)]; p99 = t[int(NR*0.99+0.999999)]
+          printf "%s,%s,%d,%s,%d,%.9f,%.9f,%.3f\n", cls, range, n, e, NR, med, p99, (sum > 0 ? NR/sum : 0)
+        }' | tee -a "$OUT.csv"
+    done
+  done
+done
+
+awk -F, -v commit="$(git rev-parse --short HEAD 2>/dev/null)" -v date="$(date -u +%FT%TZ)" '
+  BEGIN { printf "{\"commit\":\"%s\",\"date\":\"%s\",\"results\":[", commit, date }
+  NR > 1 {
+    printf "%s{\"class\":\"%s\",\"range\":%s,\"n\":%s,\"engine\":\"%s\",\"reps\":%s,\"median_s\":%s,\"p99_s\":%s,\"instances_per_s\":%s}",
+      (NR > 2 ? "," : ""), $1, ($2 == "" ? "null" : $2), $3, $4, $5, $6, $7, $8
+  }
+  END { print "]}" }' "$OUT.csv" > "$OUT.json"
+
+awk -F, 'NR == FNR { diversity[$1","$2","$3] = $4; next }
+  FNR > 1 && $4 != "auto" { sum[( diversity[$1","$2","$3] < 0.25 ? 0 : 1 ) " " $3 " " $4] += $6 }
+  END { for ( k in sum ) print k, sum[k] }' "$tmp/features" "$OUT.csv" |
+  sort -k1,1n -k2,2n -k4,4g |
+  awk -v date="$(date -u +%FT%TZ)" -v host="$(hostname)" '
+    !seen[$1 " " $2]++ { k++; group[k] = $1; n[k] = $2; engine[k] = $3 }
+    END {
+      printf "# bench.sh on %s, %s\n", host, date
+      for ( i = 1; i <= k; i++ ) {
+        last = ( i == k || group[i+1] != group[i] )
+        print engine[i] ( group[i] == 0 ? " diversity<0.25" : "" ) ( last ? "" : " n<=" n[i] )
+      }
+    }' > "$OUT.tune"
@@ -0,0 +1,112 @@
+////////////////////////////////////////////////////////////////////////
+//
+// Checks of the solve pool of libhungarian.so (hungarian_submit, see
+// hungarian.h), run by "make check"
+//
+// Random instances of several sizes are submitted together to a pool
+// with slices, their futures are collected and every cost must match
+// the one of hungarian_solve; then an engine that cannot solve, a bad
+// argument and a pool destroyed with solves still queued (whose
+// futures must all resolve, to OK or HUNGARIAN_ECANCELLED)
+//
+////////////////////////////////////////////////////////////////////////
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <random>
+#include <future>
+
+#include "hungarian.h"
+
+typedef long long ll;
+using namespace std;
+
+int failed = 0;
+
+void expect( const string& name, bool ok ) {
+  cout << ( ok ? "ok   " : "FAIL " ) << name << endl;
+  if ( not ok ) failed = 1;
+}
+
+struct Instance {
+  int n;
+  vector<int32_t> costs;
+  vector<int32_t> mate;
+  int64_t cost = -1;
+};
+
+Instance random_instance( int n, int seed ) {
+  Instance r;
+  r.n = n;
+  mt19937 rng( seed );
+  uniform_int_distribution<int32_t> cost( 0, 1000 );
+  r.costs.resize( size_t( n )*n );
+  for ( int32_t& c: r.costs ) c = cost( rng );
+  r.mate.assign( n, -1 );
+  return r;
+}
+
+future<int> submit( hungarian_pool* p, const char* engine, Instance& in ) {
+  return hungarian_submit_future( p, engine, in.n, in.costs.data(), 4*size_t( in.n ),
+				  HUNGARIAN_INT32, in.mate.data(), nullptr, nullptr, &in.cost );
+}
+
+int main() {
+
+  hungarian_workspace* w = hungarian_workspace_create();
+  hungarian_pool* p = hungarian_pool_create( 2, 1.0 );
+  if ( not w or not p ) {
+    cout << "FAIL cannot create the workspace or the pool" << endl;
+    return 1;
+  }
+
+  // several solves in flight at once, sliced and whole
+  vector<Instance> in;
+  vector<const char*> engines;
+  int seed = 1;
+  for ( int n: { 5, 40, 64, 100, 300, 600 } )
+    for ( const char* e: { "auto", "dense" } ) {
+      in.push_back( random_instance( n, seed++ ) );
+      engines.push_back( e );
+    }
+  vector<future<int>> results;
+  for ( size_t i = 0; i < in.size(); i++ )
+    results.push_back( submit( p, engines[i], in[i] ) );
+  for ( size_t i = 0; i < in.size(); i++ ) {
+    int status = results[i].get();
+    int64_t want;
+    hungarian_solve( w, in[i].n, in[i].costs.data(), 4*size_t( in[i].n ), HUNGARIAN_INT32,
+		     nullptr, nullptr, nullptr, &want );
+    ll sum = 0;
+    for ( int v = 0; v < in[i].n; v++ )
+      sum += in[i].costs[size_t( v )*in[i].n+in[i].mate[v]];
+    expect( "n=" + to_string( in[i].n ) + " " + engines[i],
+	    status == HUNGARIAN_OK and in[i].cost == want and sum == want );
+  }
+
+  Instance big = random_instance( 70, 100 );
+  expect( "fixed n=70 is EENGINE", submit( p, "fixed", big ).get() == HUNGARIAN_EENGINE );
+  expect( "bad engine is EINVAL", submit( p, "none", big ).get() == HUNGARIAN_EINVAL );
+  hungarian_pool_destroy( p );
+
+  // one worker, destroyed while the solves are running or queued
+  p = hungarian_pool_create( 1, 1.0 );
+  vector<Instance> queued;
+  for ( int i = 0; i < 6; i++ ) queued.push_back( random_instance( 800, 200+i ) );
+  results.clear();
+  for ( Instance& q: queued ) results.push_back( submit( p, "auto", q ) );
+  hungarian_pool_destroy( p );
+  int cancelled = 0, bad = 0;
+  for ( future<int>& r: results ) {
+    int status = r.get();
+    if ( status == HUNGARIAN_ECANCELLED ) cancelled++;
+    else if ( status != HUNGARIAN_OK ) bad++;
+  }
+  expect( "destroy resolves every future (" + to_string( cancelled ) + " cancelled)",
+	  bad == 0 and cancelled > 0 );
+
+  hungarian_workspace_destroy( w );
+  return failed;
+
+}
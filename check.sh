@@ -0,0 +1,80 @@
+#!/bin/bash
+#
+# Compressed input checks (see InputDecoder in hungarian.cpp): each
+# instance is solved from its text and from its gzip and zstd encodings
+# (those whose tool is installed and that hungarian.exe was built
+# for), as a regular file, through a pipe and with --batch, and every
+# cost must match the one from the text
+#
+# The texts are padded with blank lines to exact multiples of the
+# decoder block (DECODE_BLOCK), so that a compressed member ends
+# exactly when an output block is full, and the gzip case is also
+# written as two concatenated members
+#
+
+BLOCK=131072
+HUNGARIAN=${HUNGARIAN:-./hungarian.exe}
+GENERATE=${GENERATE:-./generate.exe}
+
+tmp=$(mktemp -d)
+trap 'rm -rf "$tmp"' EXIT
+failed=0
+
+# instance <n> <seed> <bytes>: a uniform instance padded to bytes
+instance() {
+  "$GENERATE" uniform "$1" "$2" > "$tmp/in.txt"
+  local size=$(stat -c %s "$tmp/in.txt")
+  if [ "$3" -gt 0 ]; then
+    [ "$size" -le "$3" ] || { echo "check: instance of $size bytes is over $3" >&2; exit 1; }
+    head -c $(( $3-size )) /dev/zero | tr '\0' '\n' >> "$tmp/in.txt"
+  fi
+}
+
+# expect <name> <expected output> <command...>
+expect() {
+  local name=$1 want=$2
+  shift 2
+  local got
+  got=$( "$@" 2>&1 )
+  if [ "$got" != "$want" ]; then
+    echo "FAIL $name: expected '$want', got '$got'"
+    failed=1
+  else
+    echo "ok   $name"
+  fi
+}
+
+codecs=""
+for codec in gzip zstd; do
+  if command -v $codec > /dev/null && \
+     [ "$( printf '1\n5\n' | $codec -q -c | "$HUNGARIAN" 2> /dev/null )" = 5 ]; then
+    codecs="$codecs $codec"
+  else
+    echo "skip $codec"
+  fi
+done
+
+for cfg in "150 1 $BLOCK" "250 2 $(( 2*BLOCK ))" "120 3 0"; do
+  set -- $cfg
+  instance "$1" "$2" "$3"
+  want=$( "$HUNGARIAN" < "$tmp/in.txt" )
+  cat "$tmp/in.txt" "$tmp/in.txt" > "$tmp/batch.txt"
+  for codec in $codecs; do
+    name="n=$1 bytes=$(stat -c %s "$tmp/in.txt") $codec"
+    if [ "$codec" = gzip ]; then
+      gzip -c < "$tmp/in.txt" > "$tmp/in.z"
+      gzip -c < "$tmp/batch.txt" > "$tmp/batch.z"
+      cat "$tmp/in.z" "$tmp/in.z" > "$tmp/members.z"
+      expect "$name members" "$( printf '%s\n%s' "$want" "$want" )" \
+	"$HUNGARIAN" --batch < "$tmp/members.z"
+    else
+      zstd -q -c < "$tmp/in.txt" > "$tmp/in.z"
+      zstd -q -c < "$tmp/batch.txt" > "$tmp/batch.z"
+    fi
+    expect "$name file" "$want" "$HUNGARIAN" < "$tmp/in.z"
+    expect "$name pipe" "$want" sh -c "cat '$tmp/in.z' | '$HUNGARIAN'"
+    expect "$name batch" "$( printf '%s\n%s' "$want" "$want" )" "$HUNGARIAN" --batch < "$tmp/batch.z"
+  done
+done
+
+exit $failed
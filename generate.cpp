@@ -0,0 +1,116 @@
+////////////////////////////////////////////////////////////////////////
+//
+// Seeded generators of standard Assignment Problem instances,
+// written in the input format of hungarian.cpp
+//
+// Usage: generate.exe [--binary|--points] <class> <N> [seed] [range]
+//
+//   uniform      c[v][u] uniform in [0,range]            (range 1000)
+//   machol-wien  c[v][u] = (v+1)*(u+1)
+//   geometric    rounded Euclidean distance between 2N random points
+//                in the square [0,range]^2                (range 1000)
+//   few-values   c[v][u] drawn from 10 random values in [0,range]
+//   long-path    c[v][u] = (N-v)*u*N + noise in [0,N), which makes
+//                most augmenting paths cover half of the rows
+//
+// With --binary the matrix is written as int64 N followed by the N*N
+// int64 costs row by row (hungarian.exe --matrix=<file>), and with
+// --points the geometric class writes its 2N points instead, for
+// hungarian.exe --points=l2 (which gives the same costs)
+//
+////////////////////////////////////////////////////////////////////////
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <random>
+#include <cmath>
+#include <cstdlib>
+
+typedef long long ll;
+using namespace std;
+
+int main(int argc, char* argv[]) {
+
+  ios::sync_with_stdio(false);
+
+  bool binary = argc > 1 and string( argv[1] ) == "--binary";
+  bool points = argc > 1 and string( argv[1] ) == "--points";
+  if ( binary or points ) {
+    argv++;
+    argc--;
+  }
+
+  if ( argc < 3 ) {
+    cerr << "usage: " << argv[0] << " [--binary|--points] <class> <N> [seed] [range]" << endl;
+    return 1;
+  }
+
+  string cls = argv[1];
+  int N = atoi( argv[2] );
+  unsigned long long seed = argc > 3 ? strtoull( argv[3], nullptr, 10 ) : 1ULL;
+  ll range = argc > 4 ? atoll( argv[4] ) : 1000LL;
+
+  mt19937_64 rng( seed );
+  auto uniform = [&]( ll lo, ll hi ) {
+    return uniform_int_distribution<ll>( lo, hi )( rng );
+  };
+
+  vector<double> x, y;
+  vector<ll> values;
+  if ( cls == "geometric" ) {
+    for ( int i = 0; i < 2*N; i++ ) {
+      x.push_back( double( uniform( 0LL, range ) ) );
+      y.push_back( double( uniform( 0LL, range ) ) );
+    }
+  } else if ( cls == "few-values" ) {
+    for ( int i = 0; i < 10; i++ )
+      values.push_back( uniform( 0LL, range ) );
+  } else if ( cls != "uniform" and cls != "machol-wien" and cls != "long-path" ) {
+    cerr << argv[0] << ": unknown class " << cls << endl;
+    return 1;
+  }
+
+  if ( points ) {
+    if ( cls != "geometric" ) {
+      cerr << argv[0] << ": --points needs the geometric class" << endl;
+      return 1;
+    }
+    cout << N << " 2\n";
+    for ( int i = 0; i < 2*N; i++ )
+      cout << ll( x[i] ) << " " << ll( y[i] ) << "\n";
+    return 0;
+  }
+
+  string line;
+  vector<ll> row( N );
+  if ( binary ) {
+    ll n = N;
+    cout.write( (const char*)( &n ), sizeof( n ) );
+  } else cout << N << "\n";
+  for ( int v = 0; v < N; v++ ) {
+    line.clear();
+    for ( int u = 0; u < N; u++ ) {
+      ll cost;
+      if ( cls == "uniform" )
+	cost = uniform( 0LL, range );
+      else if ( cls == "machol-wien" )
+	cost = ll( v+1 )*ll( u+1 );
+      else if ( cls == "geometric" )
+	cost = llround( hypot( x[v]-x[N+u], y[v]-y[N+u] ) );
+      else if ( cls == "few-values" )
+	cost = values[uniform( 0LL, 9LL )];
+      else
+	cost = ll( N-v )*ll( u )*ll( N )+uniform( 0LL, ll( N )-1LL );
+      row[u] = cost;
+      if ( binary ) continue;
+      if ( u ) line += ' ';
+      line += to_string( cost );
+    }
+    if ( binary ) cout.write( (const char*)( row.data() ), sizeof( ll )*N );
+    else cout << line << "\n";
+  }
+
+  return 0;
+
+}
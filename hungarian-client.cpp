@@ -0,0 +1,294 @@
+////////////////////////////////////////////////////////////////////////
+//
+// Client and load generator for "hungarian --serve" (see protocol.h)
+//
+// hungarian-client.exe <socket> [-m] [--engine=E] < instance
+//   solves one instance, read as in hungarian.cpp, and writes the
+//   optimal cost (or the assignment with "-m") to the standard output
+//
+// hungarian-client.exe <socket> --load [--n=100] [--requests=1000]
+//     [--connections=4] [--pipeline=8] [--seed=1] [--engine=E]
+//   sends uniform random instances over several connections, keeping
+//   up to --pipeline requests in flight on each, and writes throughput
+//   and latency percentiles as JSON; "--background-n=N" also keeps one
+//   N x N request in flight on an extra connection for the whole run
+//   (its latency is not counted), to measure how the daemon's
+//   --slice shields small requests from large ones
+//
+////////////////////////////////////////////////////////////////////////
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <random>
+#include <chrono>
+#include <thread>
+#include <unordered_map>
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <cstdlib>
+#include <cerrno>
+
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#include "protocol.h"
+
+typedef long long ll;
+using namespace std;
+
+typedef chrono::steady_clock Clock;
+
+struct Response {
+  uint32_t id;
+  int32_t status, n;
+  ll cost;
+  vector<int32_t> mate;
+};
+
+int connect_to( const string& path ) {
+
+  int fd = socket( AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0 );
+  sockaddr_un addr;
+  memset( &addr, 0, sizeof( addr ) );
+  addr.sun_family = AF_UNIX;
+  strncpy( addr.sun_path, path.c_str(), sizeof( addr.sun_path )-1 );
+  if ( fd < 0 or connect( fd, (sockaddr*)( &addr ), sizeof( addr ) ) < 0 ) {
+    cerr << "hungarian-client: cannot connect to " << path << ": " << strerror( errno ) << endl;
+    exit( 1 );
+  }
+  return fd;
+
+}
+
+bool write_all( int fd, const char* p, size_t size ) {
+
+  while ( size > 0 ) {
+    ssize_t w = send( fd, p, size, MSG_NOSIGNAL );
+    if ( w < 0 and errno == EINTR ) continue;
+    if ( w <= 0 ) return false;
+    p += w;
+    size -= size_t( w );
+  }
+  return true;
+
+}
+
+bool read_all( int fd, char* p, size_t size ) {
+
+  while ( size > 0 ) {
+    ssize_t r = recv( fd, p, size, 0 );
+    if ( r < 0 and errno == EINTR ) continue;
+    if ( r <= 0 ) return false;
+    p += r;
+    size -= size_t( r );
+  }
+  return true;
+
+}
+
+template<typename T>
+void append( string& buf, T x ) { buf.append( (const char*)( &x ), sizeof( T ) ); }
+
+string make_request( uint32_t id, uint32_t flags, int n, const vector<ll>& costs ) {
+
+  string buf;
+  buf.reserve( SERVE_REQUEST_HEADER+8*costs.size() );
+  append<uint32_t>( buf, uint32_t( SERVE_REQUEST_HEADER-4+8*costs.size() ) );
+  append<uint32_t>( buf, id );
+  append<uint32_t>( buf, flags );
+  append<int32_t>( buf, n );
+  buf.append( (const char*)( costs.data() ), 8*costs.size() );
+  return buf;
+
+}
+
+bool read_response( int fd, Response& r ) {
+
+  char header[SERVE_RESPONSE_HEADER];
+  if ( not read_all( fd, header, sizeof( header ) ) ) return false;
+
+  uint32_t size;
+  memcpy( &size, header, 4 );
+  memcpy( &r.id, header+4, 4 );
+  memcpy( &r.status, header+8, 4 );
+  memcpy( &r.n, header+12, 4 );
+  memcpy( &r.cost, header+16, 8 );
+
+  string rest( size-( SERVE_RESPONSE_HEADER-4 ), '\0' );
+  if ( not read_all( fd, &rest[0], rest.size() ) ) return false;
+  r.mate.resize( r.n );
+  memcpy( r.mate.data(), rest.data(), 4*size_t( r.n ) );
+  return true;
+
+}
+
+uint32_t engine_flags( const string& engine ) {
+
+  for ( uint32_t i = 0; i < SERVE_ENGINES; i++ )
+    if ( engine == serve_engines[i] ) return i;
+  cerr << "hungarian-client: unknown engine " << engine << endl;
+  exit( 1 );
+
+}
+
+int solve_one( const string& path, uint32_t flags, bool match ) {
+
+  int n;
+  cin >> n;
+  vector<ll> costs( size_t( n )*n );
+  for ( ll& x: costs ) cin >> x;
+
+  int fd = connect_to( path );
+  string request = make_request( 1, flags, n, costs );
+  Response r;
+  if ( not write_all( fd, request.data(), request.size() ) or not read_response( fd, r ) ) {
+    cerr << "hungarian-client: connection lost" << endl;
+    return 1;
+  }
+  close( fd );
+
+  if ( r.status != SERVE_OK ) {
+    cerr << "hungarian-client: request failed with status " << r.status << endl;
+    return 1;
+  }
+  if ( match )
+    for ( int v = 0; v < r.n; v++ ) cout << r.mate[v] << "\n";
+  else
+    cout << r.cost << "\n";
+  return 0;
+
+}
+
+int load( const string& path, uint32_t flags, int n, int requests,
+	  int connections, int pipeline, unsigned long long seed, int background_n ) {
+
+  // a few instances are reused so that generation stays off the clock
+  mt19937_64 rng( seed );
+  vector<string> instances;
+  for ( int k = 0; k < 16; k++ ) {
+    vector<ll> costs( size_t( n )*n );
+    for ( ll& x: costs ) x = ll( rng()%1001ULL );
+    instances.push_back( make_request( 0, flags, n, costs ) );
+  }
+
+  vector<vector<double>> latency( connections );
+  vector<int> errors( connections, 0 );
+  vector<thread> pool;
+
+  atomic<bool> finished{ false };
+  int background = 0, background_errors = 0;
+  thread large;
+  if ( background_n > 0 ) {
+    vector<ll> costs( size_t( background_n )*background_n );
+    for ( ll& x: costs ) x = ll( rng()%1001ULL );
+    string request = make_request( 0, flags, background_n, costs );
+    large = thread( [&,request]() {
+      int fd = connect_to( path );
+      Response r;
+      while ( not finished ) {
+	if ( not write_all( fd, request.data(), request.size() ) or not read_response( fd, r ) ) {
+	  background_errors++;
+	  break;
+	}
+	if ( r.status != SERVE_OK ) background_errors++;
+	background++;
+      }
+      close( fd );
+    } );
+  }
+  Clock::time_point t0 = Clock::now();
+
+  for ( int t = 0; t < connections; t++ )
+    pool.emplace_back( [&,t]() {
+      vector<string> mine = instances;  // ids are patched in place
+      int fd = connect_to( path );
+      int quota = requests/connections+( t < requests%connections ? 1 : 0 );
+      unordered_map<uint32_t,Clock::time_point> in_flight;
+      uint32_t next = 0;
+      int received = 0;
+      while ( received < quota ) {
+	while ( int( next ) < quota and int( in_flight.size() ) < pipeline ) {
+	  string& request = mine[next%mine.size()];
+	  memcpy( &request[4], &next, 4 );
+	  in_flight[next] = Clock::now();
+	  if ( not write_all( fd, request.data(), request.size() ) ) { errors[t]++; return; }
+	  next++;
+	}
+	Response r;
+	if ( not read_response( fd, r ) ) { errors[t]++; return; }
+	auto it = in_flight.find( r.id );
+	if ( it == in_flight.end() or r.status != SERVE_OK ) errors[t]++;
+	else {
+	  latency[t].push_back( chrono::duration<double>( Clock::now()-it->second ).count() );
+	  in_flight.erase( it );
+	}
+	received++;
+      }
+      close( fd );
+    } );
+  for ( thread& th: pool ) th.join();
+
+  double seconds = chrono::duration<double>( Clock::now()-t0 ).count();
+  finished = true;
+  if ( large.joinable() ) large.join();
+  vector<double> all;
+  int failed = 0;
+  for ( int t = 0; t < connections; t++ ) {
+    all.insert( all.end(), latency[t].begin(), latency[t].end() );
+    failed += errors[t];
+  }
+  failed += background_errors;
+  sort( all.begin(), all.end() );
+  auto pct = [&]( double p ) {
+    return all.empty() ? 0.0 : 1e3*all[min( all.size()-1, size_t( p*all.size() ) )];
+  };
+
+  cout << "{\"n\":" << n << ",\"requests\":" << all.size() << ",\"errors\":" << failed
+       << ",\"connections\":" << connections << ",\"pipeline\":" << pipeline
+       << ",\"seconds\":" << seconds
+       << ",\"requests_per_s\":" << ( seconds > 0.0 ? all.size()/seconds : 0.0 )
+       << ",\"latency_ms\":{\"p50\":" << pct( 0.50 ) << ",\"p90\":" << pct( 0.90 )
+       << ",\"p99\":" << pct( 0.99 ) << ",\"max\":" << pct( 1.0 ) << "}";
+  if ( background_n > 0 )
+    cout << ",\"background\":{\"n\":" << background_n << ",\"requests\":" << background << "}";
+  cout << "}" << endl;
+  return failed ? 1 : 0;
+
+}
+
+int main(int argc, char* argv[]) {
+
+  ios::sync_with_stdio(false);
+  cin.tie(nullptr);
+
+  if ( argc < 2 ) {
+    cerr << "usage: " << argv[0] << " <socket> [-m] [--engine=E] [--load ...]" << endl;
+    return 1;
+  }
+
+  string path = argv[1];
+  bool match = false, load_test = false;
+  uint32_t flags = 0;
+  int n = 100, requests = 1000, connections = 4, pipeline = 8, background_n = 0;
+  unsigned long long seed = 1ULL;
+  for ( int i = 2; i < argc; i++ ) {
+    string opt = argv[i];
+    if ( opt == "-m" or opt == "--match" ) match = true;
+    else if ( opt == "--load" ) load_test = true;
+    else if ( opt.compare( 0, 9, "--engine=" ) == 0 ) flags = engine_flags( opt.substr( 9 ) );
+    else if ( opt.compare( 0, 4, "--n=" ) == 0 ) n = atoi( opt.c_str()+4 );
+    else if ( opt.compare( 0, 11, "--requests=" ) == 0 ) requests = atoi( opt.c_str()+11 );
+    else if ( opt.compare( 0, 14, "--connections=" ) == 0 ) connections = atoi( opt.c_str()+14 );
+    else if ( opt.compare( 0, 11, "--pipeline=" ) == 0 ) pipeline = atoi( opt.c_str()+11 );
+    else if ( opt.compare( 0, 15, "--background-n=" ) == 0 ) background_n = atoi( opt.c_str()+15 );
+    else if ( opt.compare( 0, 7, "--seed=" ) == 0 ) seed = strtoull( opt.c_str()+7, nullptr, 10 );
+  }
+
+  if ( load_test )
+    return load( path, flags, n, requests, max( 1, connections ), max( 1, pipeline ), seed, background_n );
+  return solve_one( path, flags, match );
+
+}
@@ -16,6 +16,52 @@
 // The code reads the instance from the standard input and
 // writes the value of the optimal assignment to the standard output.
 // To output the assignment itself use "-m" or "--match"
+// ("--match=binary" writes it as raw int32) and "--json" writes the
+// cost, the assignment and the duals as a JSON object
+// To write a JSON report with phase timings to stderr use "--stats"
+// (build with -DHUNGARIAN_STATS to also get the hot-path counters)
+// and "--perf" to add Linux hardware counters to that report
+// The solver engine is chosen from N and a sample of the rows (see
+// choose_engine; "--tune=FILE" replaces its rules) unless
+// "--engine=fixed|dense|packed"
+// ("--engine=pruned" solves on the "--candidates=K" cheapest edges of
+// each row first and adds edges until the duals are feasible)
+// "--verify" checks the optimality certificate (mate_V, alpha, beta)
+// "--serve <socket>" runs a solver daemon instead (see protocol.h),
+// with "--threads=T" workers; "--slice=MS" makes them take turns on
+// long solves every MS milliseconds, so that short requests are not
+// stuck behind them (0, the default, runs each solve to completion)
+// "--cache=MB" keeps solved instances in an LRU cache (useful with
+// --serve): repeated matrices are answered from it and matrices that
+// differ in a few rows restart from the cached duals
+// "--matrix=<file>" solves a binary matrix (int64 N, then the int64
+// costs row by row) from disk through a row cache of "--row-cache=MB"
+// instead of reading the standard input (see generate.cpp --binary)
+// "--points=l1|l2|sql2|cosine" reads two point sets instead ("N d",
+// then N points of V and N points of U, d coordinates each) and
+// computes c[v][u] = round(scale*dist(v,u)) on the fly ("--scale=S",
+// 1 by default, fixes the precision of fractional distances)
+// The in-memory matrix uses huge pages when it can ("--no-huge-pages"
+// turns that off) and, with libnuma, "--numa=interleave|partition|off"
+// places its rows on the NUMA nodes (interleave by default)
+// Built as libhungarian.so (-DHUNGARIAN_LIBRARY) the solver is called
+// through the C API of hungarian.h instead
+// "--deadline=MS" stops the search MS milliseconds after the input is
+// read and completes the assignment greedily on reduced costs; the
+// cost, the dual lower bound and the gap are reported on stderr (only
+// with "--engine=auto" or "--engine=dense")
+//
+// When the standard input is a file it is parsed by "--threads=T"
+// threads (all cores by default), else it is read as a stream
+// gzip and zstd input is decoded on the fly (with zlib and libzstd)
+// "--capacitated" reads "n m", an n x m matrix and m column
+// capacities instead, and assigns every row to a column within them
+// "--forbidden=X" makes the costs >= X forbidden edges; the rows and
+// columns they leave connected are solved as separate blocks, in
+// parallel on "--threads=T" threads
+// "--batch" solves a sequence of instances from the standard input and
+// writes their results in order, reading, parsing, solving (on
+// "--threads=T" lanes) and writing in a pipeline
 //
 // The input should describe the cost matrix like this example from [1]:
 //
@@ -30,189 +76,4554 @@
 
 #include <iostream>
 #include <string>
+#include <sstream>
+#include <fstream>
 #include <limits>
 #include <vector>
+#include <array>
+#include <utility>
+#include <chrono>
+#include <cstring>
+#include <cerrno>
+#include <thread>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <unordered_map>
+#include <list>
+#include <csignal>
+#include <cstdlib>
+#include <cmath>
+#include <algorithm>
+#include <atomic>
+#include <functional>
+
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#endif
+
+#ifdef HUNGARIAN_NUMA
+#include <numa.h>
+#endif
+#ifdef HUNGARIAN_ZLIB
+#include <zlib.h>
+#endif
+#ifdef HUNGARIAN_ZSTD
+#include <zstd.h>
+#endif
+
+#include "protocol.h"
+#include "hungarian.h"
 
 typedef long long ll;
 using namespace std;
 
-int N;
-vector<vector<ll>> c;
-vector<int> mate_V,mate_U,nhbor,parent;
-vector<ll> alpha,beta,slack,min_col;
-vector<bool> label_V,label_U;
+////////////////////////////////////////////////////////////////////////
+//
+// Instrumentation: phase timings are always taken (a few clock reads);
+// hot-path counters only exist when compiled with -DHUNGARIAN_STATS
+//
+////////////////////////////////////////////////////////////////////////
+
+typedef chrono::steady_clock Clock;
+
+double seconds_since( Clock::time_point t0 ) {
+  return chrono::duration<double>( Clock::now()-t0 ).count();
+}
+
+struct Timings {
+  double read_input = 0.0, initialization = 0.0, search = 0.0, output = 0.0;
+  double verify = 0.0;
+};
+
+// what "--engine=auto" saw and picked (see choose_engine)
+struct EngineChoice {
+  bool made = false;
+  int n = 0, sampled = 0;
+  ll min_cost = 0LL, max_cost = 0LL;
+  double spread = 0.0, diversity = 0.0;
+  string rule, engine;
+};
+
+// how "--forbidden" split the instance (see solve_blocks)
+struct Decomposition {
+  int blocks = 0, largest = 0, threads = 0;
+  string engine;                // of the largest block
+};
+
+#ifdef HUNGARIAN_STATS
+struct Counters {
+  ll update_slack_calls = 0, columns_scanned = 0;
+  ll theta_steps = 0, zero_theta_steps = 0;
+  ll admissibles = 0, alpha_beta_columns = 0;
+  ll labelled = 0, path = 0;          // current search
+  vector<ll> search_size, path_length; // per outer iteration
+};
+thread_local Counters counters;
+#define COUNT(stmt) stmt
+
+// the counters of the block workers (see solve_blocks), added once
+// they have joined; the report prints them with the main thread's
+Counters merged;
+
+void count_merge( Counters& to, const Counters& from ) {
+  to.update_slack_calls += from.update_slack_calls;
+  to.columns_scanned += from.columns_scanned;
+  to.theta_steps += from.theta_steps;
+  to.zero_theta_steps += from.zero_theta_steps;
+  to.admissibles += from.admissibles;
+  to.alpha_beta_columns += from.alpha_beta_columns;
+  to.search_size.insert( to.search_size.end(), from.search_size.begin(), from.search_size.end() );
+  to.path_length.insert( to.path_length.end(), from.path_length.begin(), from.path_length.end() );
+}
+
+void count_search( ll labelled ) {
+  counters.labelled = labelled;
+  counters.path = 0;
+}
+
+void count_augment() {
+  counters.search_size.push_back( counters.labelled );
+  counters.path_length.push_back( counters.path );
+}
+#else
+#define COUNT(stmt)
+#endif
+
+////////////////////////////////////////////////////////////////////////
+//
+// Hardware counters (perf_event_open), one fd per event so that a
+// missing event only drops its own column. Phases are always sampled
+// when enabled; the update_slack / update_alpha_beta kernels only in
+// -DHUNGARIAN_STATS builds (a read() per event per call is not free).
+// The events are inherited, so a phase also counts the threads it
+// starts (parse, verify, blocks), but only the thread that opened them
+// samples phases: the PerfCounts are not shared with --serve, --batch
+// or block workers, whose own solves are not timed.
+//
+////////////////////////////////////////////////////////////////////////
+
+const int PERF_EVENTS = 5;
+const char* perf_names[PERF_EVENTS] =
+  { "cycles", "instructions", "llc_misses", "dtlb_misses", "branch_misses" };
+
+struct PerfCounts {
+  ll v[PERF_EVENTS] = {}, start[PERF_EVENTS] = {};
+  ll calls = 0;
+};
+
+struct Perf {
+  bool enabled = false;
+  int fd[PERF_EVENTS] = { -1, -1, -1, -1, -1 };
+  string error;
+  PerfCounts read_input, initialization, search, output;
+  PerfCounts update_slack, update_alpha_beta;
+} perf;
+
+thread_local bool perf_thread = false; // the thread that opened perf
 
-bool unlabelled_U( int u ) { return not label_U[u]; }
-bool unmatched_V( int v ) { return mate_V[v] == -1; }
-bool unmatched_U( int u ) { return mate_U[u] == -1; }
-bool admissible_U( int u ) { return slack[u] == 0LL; }
+void perf_open() {
 
-void augment( int v, int exposed_u ) {
+#ifdef __linux__
+  const unsigned long long cache_read_miss =
+    PERF_COUNT_HW_CACHE_OP_READ << 8 | PERF_COUNT_HW_CACHE_RESULT_MISS << 16;
+  const pair<unsigned,unsigned long long> events[PERF_EVENTS] = {
+    { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES },
+    { PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS },
+    { PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_LL | cache_read_miss },
+    { PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_DTLB | cache_read_miss },
+    { PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES } };
 
-  int aux = mate_V[v];
+  for ( int i = 0; i < PERF_EVENTS; i++ ) {
+    perf_event_attr attr;
+    memset( &attr, 0, sizeof( attr ) );
+    attr.size = sizeof( attr );
+    attr.type = events[i].first;
+    attr.config = events[i].second;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    attr.inherit = 1;
 
-  mate_V[v] = exposed_u;
-  mate_U[exposed_u] = v;
+    perf.fd[i] = syscall( __NR_perf_event_open, &attr, 0, -1, -1, 0 );
+    if ( perf.fd[i] < 0 ) perf.error = strerror( errno );
+    else perf.enabled = true;
+  }
+  perf_thread = true;
+#else
+  perf.error = "perf_event_open is Linux only";
+#endif
+
+}
+
+void perf_sample( ll* v ) {
+
+#ifdef __linux__
+  for ( int i = 0; i < PERF_EVENTS; i++ )
+    if ( perf.fd[i] < 0 or read( perf.fd[i], &v[i], sizeof( ll ) ) != sizeof( ll ) )
+      v[i] = 0LL;
+#endif
+
+}
+
+void perf_begin( PerfCounts& p ) {
+  if ( perf.enabled and perf_thread ) perf_sample( p.start );
+}
+
+void perf_end( PerfCounts& p ) {
+
+  if ( not perf.enabled or not perf_thread ) return;
+
+  ll end[PERF_EVENTS];
+  perf_sample( end );
+  for ( int i = 0; i < PERF_EVENTS; i++ )
+    p.v[i] += end[i]-p.start[i];
+  p.calls++;
+
+}
+
+////////////////////////////////////////////////////////////////////////
+//
+// In-memory cost matrix: one N*N block from mmap, so that it can be
+// backed by huge pages (MAP_HUGETLB if pages are reserved, else
+// transparent huge pages through madvise, else 4KB pages) and placed
+// on NUMA nodes before read_input first touches it: interleaved, or
+// partitioned into row ranges that match the thread split of
+// verify_certificate. NUMA placement needs libnuma (-DHUNGARIAN_NUMA,
+// set by the Makefile when numa.h is installed).
+//
+////////////////////////////////////////////////////////////////////////
+
+enum NumaPolicy { NUMA_OFF, NUMA_INTERLEAVE, NUMA_PARTITION };
 
-  if ( parent[v] != -1 )
-    augment( parent[v], aux );
+struct MatrixPolicy {
+  bool huge_pages = true;
+  NumaPolicy numa = NUMA_INTERLEAVE;
+} matrix_policy;
 
+const size_t HUGE_PAGE = size_t( 2 ) << 20;
+
+// number of NUMA nodes the matrix can be spread over (1 without libnuma)
+int numa_nodes() {
+#ifdef HUNGARIAN_NUMA
+  return numa_available() < 0 ? 1 : numa_max_node()+1;
+#else
+  return 1;
+#endif
+}
+
+// runs the calling thread on the node holding part of parts row ranges
+void numa_pin( int part, int parts ) {
+#ifdef HUNGARIAN_NUMA
+  if ( matrix_policy.numa == NUMA_PARTITION and numa_nodes() > 1 )
+    numa_run_on_node( int( ll( part )*numa_nodes()/parts ) );
+#else
+  (void)( part );
+  (void)( parts );
+#endif
 }
 
-void update_slack( int v ) {
+struct CostMatrix {
+
+  int n = 0;
+  ll* data = nullptr;
+  size_t bytes = 0;             // mapped, kept for reuse by smaller n
+  const char* pages = "none";
+  const char* placement = "local";
+
+  CostMatrix() {}
+  CostMatrix( const CostMatrix& ) = delete;
+  CostMatrix& operator=( const CostMatrix& ) = delete;
+  ~CostMatrix() { release(); }
+
+  ll* operator[]( int v ) { return data+size_t( v )*n; }
+  const ll* operator[]( int v ) const { return data+size_t( v )*n; }
+
+  void release() {
+    if ( data ) munmap( data, bytes );
+    data = nullptr;
+    bytes = 0;
+  }
+
+  void clear() {
+    release();
+    n = 0;
+  }
+
+  // n x n, uninitialized
+  void assign( int size ) {
+
+    n = size;
+    size_t need = max( size_t( 1 ), 8*size_t( n )*n );
+    if ( need <= bytes ) return;
+    release();
 
-  // for unlabelled u in U
-  for ( int u = 0; u < N; u++ )
-    if ( unlabelled_U( u ) ) {
-      ll bound = c[v][u]-alpha[v]-beta[u];
-      if ( 0LL <= bound and bound < slack[u] ) {
-	slack[u] = bound;
-	nhbor[u] = v;
+    bool huge = matrix_policy.huge_pages and need >= HUGE_PAGE;
+    bytes = huge ? ( need+HUGE_PAGE-1 )/HUGE_PAGE*HUGE_PAGE : need;
+    void* p = MAP_FAILED;
+#ifdef MAP_HUGETLB
+    if ( huge ) p = mmap( nullptr, bytes, PROT_READ | PROT_WRITE,
+			  MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0 );
+    pages = "hugetlb";
+#endif
+    if ( p == MAP_FAILED ) {
+      p = mmap( nullptr, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0 );
+      if ( p == MAP_FAILED ) throw bad_alloc();
+      pages = "4k";
+#ifdef MADV_HUGEPAGE
+      if ( huge and madvise( p, bytes, MADV_HUGEPAGE ) == 0 ) pages = "thp";
+#endif
+    }
+    data = (ll*)( p );
+    place();
+
+  }
+
+  // NUMA placement of the (untouched) pages
+  void place() {
+
+    placement = "local";
+#ifdef HUNGARIAN_NUMA
+    int nodes = numa_nodes();
+    if ( nodes < 2 or matrix_policy.numa == NUMA_OFF ) return;
+    if ( matrix_policy.numa == NUMA_INTERLEAVE ) {
+      numa_interleave_memory( data, bytes, numa_all_nodes_ptr );
+      placement = "interleave";
+      return;
+    }
+    size_t page = size_t( sysconf( _SC_PAGESIZE ) );
+    for ( int k = 0; k < nodes; k++ ) {
+      size_t from = 8*size_t( n )*size_t( ll( n )*k/nodes )/page*page;
+      size_t to = k+1 == nodes ? bytes : 8*size_t( n )*size_t( ll( n )*( k+1 )/nodes )/page*page;
+      if ( to > from ) numa_tonode_memory( (char*)( data )+from, to-from, k );
+    }
+    placement = "partition";
+#endif
+
+  }
+
+};
+
+////////////////////////////////////////////////////////////////////////
+//
+// Out-of-core storage: the cost matrix stays in a binary file (int64
+// N, then N*N int64 costs row-major) that is mmapped, or read with
+// pread if mmap fails. update_slack reads one row at a time, so rows
+// go through a bounded CLOCK cache of doubled copies, and the search
+// asks the kernel to start reading the rows it is about to label.
+//
+////////////////////////////////////////////////////////////////////////
+
+struct MatrixFile {
+
+  int fd = -1, N = 0;
+  const ll* map = nullptr;      // whole file, if mmap worked
+  size_t map_size = 0;
+
+  size_t rows = 0;              // capacity of the row cache
+  vector<ll> slots;             // rows*N doubled costs
+  vector<int> slot_row, row_slot;
+  vector<bool> referenced;
+  size_t hand = 0;
+  ll row_reads = 0, row_hits = 0;
+
+  ~MatrixFile() {
+    if ( map ) munmap( (void*)( map ), map_size );
+    if ( fd >= 0 ) close( fd );
+  }
+
+  const char* kind() const { return map ? "mmap" : "pread"; }
+
+  // returns an empty string on success, else the reason
+  string open_file( const string& path, size_t cache_bytes ) {
+
+    fd = open( path.c_str(), O_RDONLY | O_CLOEXEC );
+    ll n = 0;
+    struct stat st;
+    if ( fd < 0 or fstat( fd, &st ) < 0 )
+      return path+": "+strerror( errno );
+    ssize_t got = pread( fd, &n, 8, 0 );
+    if ( got < 0 )
+      return path+": "+strerror( errno );
+    // 8*n*n overflows for n above about 1.07e9: compare n first
+    ll body = ll( st.st_size )-8LL;
+    if ( got != 8 or n < 0 or n > numeric_limits<int>::max() or
+	 ( n > 0 and n > body/8LL/n ) or body != 8LL*n*n )
+      return path+": not an int64 N x N matrix";
+    N = int( n );
+
+    map_size = size_t( st.st_size );
+    void* p = N ? mmap( nullptr, map_size, PROT_READ, MAP_SHARED, fd, 0 ) : MAP_FAILED;
+    if ( p != MAP_FAILED ) map = (const ll*)( p );
+
+    rows = max( size_t( 1 ), min( size_t( N ), cache_bytes/( 8*size_t( max( N, 1 ) ) ) ) );
+    slots.resize( rows*N );
+    slot_row.assign( rows, -1 );
+    row_slot.assign( N, -1 );
+    referenced.assign( rows, false );
+    return "";
+
+  }
+
+  // rows are read in order once (min_col), then in search order
+  void advise( bool sequential ) {
+    if ( map ) madvise( (void*)( map ), map_size, sequential ? MADV_SEQUENTIAL : MADV_RANDOM );
+  }
+
+  // doubled copy of row v into out; thread safe
+  void read_row( int v, ll* out ) const {
+
+    off_t offset = off_t( 8 )+off_t( 8 )*N*v;
+    if ( map )
+      memcpy( out, map+offset/8, 8*size_t( N ) );
+    else {
+      size_t done = 0;
+      while ( done < 8*size_t( N ) ) {
+	ssize_t r = pread( fd, (char*)( out )+done, 8*size_t( N )-done, offset+done );
+	if ( r < 0 and errno == EINTR ) continue;
+	// 0 is the end of the file: it was truncated after open_file
+	if ( r <= 0 ) {
+	  cerr << "hungarian: matrix read error: "
+	       << ( r == 0 ? "unexpected end of file" : strerror( errno ) ) << endl;
+	  exit( 1 );
+	}
+	done += size_t( r );
       }
     }
-  
-}
+    for ( int u = 0; u < N; u++ )
+      out[u] *= 2LL;
+
+  }
+
+  // row v through the cache; valid until the next call
+  const ll* row( int v ) {
+
+    if ( row_slot[v] != -1 ) {
+      row_hits++;
+      referenced[row_slot[v]] = true;
+      return &slots[size_t( row_slot[v] )*N];
+    }
+
+    while ( referenced[hand] ) {
+      referenced[hand] = false;
+      hand = ( hand+1 )%rows;
+    }
+    size_t slot = hand;
+    hand = ( hand+1 )%rows;
+    if ( slot_row[slot] != -1 ) row_slot[slot_row[slot]] = -1;
+    slot_row[slot] = v;
+    row_slot[v] = int( slot );
+    referenced[slot] = true;
+
+    row_reads++;
+    read_row( v, &slots[slot*N] );
+    return &slots[slot*N];
+
+  }
+
+  // ask the kernel to start reading row v (no-op if it is cached)
+  void prefetch( int v ) const {
+
+    if ( row_slot[v] != -1 ) return;
+    size_t offset = 8+8*size_t( N )*v, length = 8*size_t( N );
+    if ( map ) {
+      size_t page = size_t( sysconf( _SC_PAGESIZE ) );
+      size_t start = offset/page*page;
+      madvise( (char*)( map )+start, offset+length-start, MADV_WILLNEED );
+    }
+#ifdef POSIX_FADV_WILLNEED
+    else posix_fadvise( fd, off_t( offset ), off_t( length ), POSIX_FADV_WILLNEED );
+#endif
+
+  }
+
+};
+
+////////////////////////////////////////////////////////////////////////
+//
+// Implicit costs: c[v][u] = round(scale*dist(p_v,q_u)) between two
+// point sets, computed one row at a time, so memory is O(N*d) instead
+// of O(N^2). U is stored by dimension so that the row loops run over
+// contiguous columns and vectorize.
+//
+////////////////////////////////////////////////////////////////////////
+
+enum Metric { METRIC_L1, METRIC_L2, METRIC_SQL2, METRIC_COSINE };
 
-ll update_alpha_beta() {
-  
-  ll theta = numeric_limits<ll>::max();
+struct PointSet {
 
-  // for unlabelled u in U
-  for ( int u = 0; u < N; u++ )
-    if ( unlabelled_U( u ) )
-      theta = min( theta, slack[u] );
-  
-  // skip if theta == 0 (no update needed)
-  if ( theta > 0LL ) {
-    
-    // integrality is ensured
-    theta /= 2LL;
-    
+  int N = 0, d = 0;
+  Metric metric = METRIC_L2;
+  string name;
+  double scale = 1.0;
+  vector<double> V;             // N x d, point by point
+  vector<double> U;             // d x N, dimension by dimension
+  vector<double> norm_V, norm_U;
+  vector<ll> buf;               // row returned by row()
+
+  // returns an empty string on success, else the reason
+  string read( istream& in, const string& metric_name, double s ) {
+
+    if ( metric_name == "l1" ) metric = METRIC_L1;
+    else if ( metric_name == "l2" ) metric = METRIC_L2;
+    else if ( metric_name == "sql2" ) metric = METRIC_SQL2;
+    else if ( metric_name == "cosine" ) metric = METRIC_COSINE;
+    else return "unknown metric "+metric_name;
+    name = metric_name;
+    scale = s;
+
+    if ( not ( in >> N >> d ) or N < 0 or d <= 0 ) return "bad point set header";
+    V.resize( size_t( N )*d );
+    U.resize( size_t( N )*d );
+    for ( double& x: V ) in >> x;
+    for ( int u = 0; u < N; u++ )
+      for ( int k = 0; k < d; k++ )
+	in >> U[size_t( k )*N+u];
+    if ( not in ) return "truncated point set";
+
+    norm_V.assign( N, 0.0 );
+    norm_U.assign( N, 0.0 );
     for ( int i = 0; i < N; i++ ) {
-      if ( label_V[i] ) alpha[i] += theta;
-      else alpha[i] -= theta;
-      if ( label_U[i] ) beta[i] -= theta;
-      else beta[i] += theta;
+      for ( int k = 0; k < d; k++ ) {
+	norm_V[i] += V[size_t( i )*d+k]*V[size_t( i )*d+k];
+	norm_U[i] += U[size_t( k )*N+i]*U[size_t( k )*N+i];
+      }
+      norm_V[i] = sqrt( norm_V[i] );
+      norm_U[i] = sqrt( norm_U[i] );
     }
+    buf.resize( N );
+    return "";
+
   }
-  
-  return theta;
-}
 
-int search_augmenting_alternating_path() {
+  // doubled row v into out; thread safe
+  void fill( int v, ll* out ) const {
+
+    thread_local vector<double> acc;
+    acc.assign( N, 0.0 );
+    double* a = acc.data();
+    const double* p = &V[size_t( v )*d];
+
+    for ( int k = 0; k < d; k++ ) {
+      const double x = p[k], *q = &U[size_t( k )*N];
+      if ( metric == METRIC_L1 )
+	for ( int u = 0; u < N; u++ ) a[u] += fabs( x-q[u] );
+      else if ( metric == METRIC_COSINE )
+	for ( int u = 0; u < N; u++ ) a[u] += x*q[u];
+      else
+	for ( int u = 0; u < N; u++ ) a[u] += ( x-q[u] )*( x-q[u] );
+    }
+
+    if ( metric == METRIC_L2 )
+      for ( int u = 0; u < N; u++ ) a[u] = sqrt( a[u] );
+    else if ( metric == METRIC_COSINE )
+      for ( int u = 0; u < N; u++ ) {
+	double norms = norm_V[v]*norm_U[u];
+	a[u] = norms > 0.0 ? 1.0-a[u]/norms : 1.0;
+      }
+    for ( int u = 0; u < N; u++ )
+      out[u] = 2LL*llround( scale*a[u] );
+
+  }
+
+  // row v, valid until the next call
+  const ll* row( int v ) {
+    fill( v, buf.data() );
+    return buf.data();
+  }
+
+};
+
+////////////////////////////////////////////////////////////////////////
+//
+// Caller-owned costs (C API): n rows of n int32 or int64 costs that
+// start stride bytes apart, read in place and doubled one row at a
+// time like the point sets, so the solver adds O(N) memory to the
+// caller's matrix instead of a doubled int64 copy of it.
+//
+////////////////////////////////////////////////////////////////////////
+
+struct CallerMatrix {
+
+  int N = 0;
+  const char* costs = nullptr;
+  size_t stride = 0;
+  bool wide = true;             // int64, else int32
+  vector<ll> buf;               // row returned by row()
+
+  template<typename T>
+  void fill_as( int v, ll* out ) const {
+    const T* cv = (const T*)( costs+stride*v );
+    for ( int u = 0; u < N; u++ ) out[u] = 2LL*ll( cv[u] );
+  }
+
+  // doubled row v into out; thread safe
+  void fill( int v, ll* out ) const {
+    if ( wide ) fill_as<int64_t>( v, out );
+    else fill_as<int32_t>( v, out );
+  }
+
+  // row v, valid until the next call
+  const ll* row( int v ) {
+    fill( v, buf.data() );
+    return buf.data();
+  }
+
+  // doubled c[v][u], for the few columns of a pruned row
+  ll at( int v, int u ) const {
+    const char* p = costs+stride*v;
+    return 2LL*( wide ? ll( ( (const int64_t*)( p ) )[u] ) : ll( ( (const int32_t*)( p ) )[u] ) );
+  }
+
+};
+
+////////////////////////////////////////////////////////////////////////
+//
+// Solver workspace: the instance, the matching, the duals and the
+// search state. Vectors are reassigned in place, so a workspace that
+// is reused for several instances keeps its memory warm.
+//
+////////////////////////////////////////////////////////////////////////
+
+// rows per fused update_slack_block call and columns per tile
+const int UPDATE_SLACK_ROWS = 8;
+const int UPDATE_SLACK_TILE = 1024;
+
+// software prefetch of the rows about to be scanned: the first
+// PREFETCH_LINES cache lines of the rows one block of UPDATE_SLACK_ROWS
+// ahead (PREFETCH_AHEAD rows); the hardware stream prefetcher takes
+// over from there
+const int PREFETCH_LINES = 8;
+const int PREFETCH_AHEAD = UPDATE_SLACK_ROWS;
+
+struct HungarianSolver {
+
+  int N = 0;
+  CostMatrix c;
+  vector<int> mate_V,mate_U,nhbor,parent;
+  vector<ll> alpha,beta,slack,min_col;
+  vector<bool> label_V,label_U;
+  vector<uint64_t> row_hash;   // of the input rows, for the result cache
+  unique_ptr<MatrixFile> file; // out-of-core c, if not null
+  unique_ptr<PointSet> points; // implicit c, if not null
+  unique_ptr<CallerMatrix> caller; // c owned by the caller, if not null
+  vector<vector<int>> cand;    // candidate columns of each row, if not empty
+  bool has_deadline = false;   // anytime mode: stop the search at deadline
+  Clock::time_point deadline;
+  bool stopped = false;        // the search was stopped, see complete_greedily
+  int matched_at_stop = 0;
+  const atomic<bool>* cancel = nullptr; // abandon the solve when set
+  bool cancelled = false;      // it was: mate_V is partial
+  function<void(int,ll)> progress; // (matched rows, dual lower bound)
+  int prune_k = 16, prune_rounds = 0;
+  ll prune_edges = 0LL;
+  ll forbidden = numeric_limits<ll>::max(); // entries from here up are not edges
+  Timings timings;
+  EngineChoice choice;
+  Decomposition decomposition;
+
+  // row v of the (doubled) cost matrix
+  const ll* row( int v ) {
+    if ( file ) return file->row( v );
+    if ( points ) return points->row( v );
+    if ( caller ) return caller->row( v );
+    return c[v];
+  }
+
+  // same, thread safe: file, point and caller rows are copied into buf
+  const ll* row( int v, vector<ll>& buf ) const {
+    if ( not file and not points and not caller ) return c[v];
+    buf.resize( N );
+    if ( file ) file->read_row( v, buf.data() );
+    else if ( points ) points->fill( v, buf.data() );
+    else caller->fill( v, buf.data() );
+    return buf.data();
+  }
+
+  // start loading the first lines of in-memory row v
+  void prefetch_row( int v ) const {
+    if ( file or points or caller ) return;
+    const char* p = (const char*)( c[v] );
+    for ( int l = 0; l < PREFETCH_LINES; l++ )
+      __builtin_prefetch( p+64*l );
+  }
+
+  // name of the cost storage, for --stats
+  string storage() const {
+    if ( file ) return file->kind();
+    if ( points ) return "points:"+points->name;
+    if ( caller ) return "caller";
+    return "memory";
+  }
+
+  bool unlabelled_U( int u ) { return not label_U[u]; }
+  bool unmatched_V( int v ) { return mate_V[v] == -1; }
+  bool unmatched_U( int u ) { return mate_U[u] == -1; }
+  bool admissible_U( int u ) { return slack[u] == 0LL; }
+
+  void augment( int v, int exposed_u ) {
+
+    int aux = mate_V[v];
+
+    COUNT( counters.path++ );
+    mate_V[v] = exposed_u;
+    mate_U[exposed_u] = v;
+
+    if ( parent[v] != -1 )
+      augment( parent[v], aux );
+
+  }
+
+  void update_slack( int v ) {
+
+    COUNT( perf_begin( perf.update_slack ) );
+    COUNT( counters.update_slack_calls++ );
+
+    // pruned: only the candidate edges of v (caller rows are read in
+    // place rather than converted whole)
+    if ( not cand.empty() ) {
+      const ll* cv = caller ? nullptr : row( v );
+      for ( int u: cand[v] )
+	if ( unlabelled_U( u ) ) {
+	  COUNT( counters.columns_scanned++ );
+	  ll bound = ( cv ? cv[u] : caller->at( v, u ) )-alpha[v]-beta[u];
+	  if ( 0LL <= bound and bound < slack[u] ) {
+	    slack[u] = bound;
+	    nhbor[u] = v;
+	  }
+	}
+      COUNT( perf_end( perf.update_slack ) );
+      return;
+    }
 
-  while ( true ) {
-    ll theta = update_alpha_beta();
-    
-    vector<int> admissibles = vector<int>();
-    
     // for unlabelled u in U
+    const ll* cv = row( v );
     for ( int u = 0; u < N; u++ )
       if ( unlabelled_U( u ) ) {
-	slack[u] -= 2LL*theta;
-	if ( admissible_U( u ) ) {
-	  // unlabelled, admissible and unmatched => path found
-	  if ( unmatched_U( u ) ) return u;
-	  else admissibles.push_back( u );
+	COUNT( counters.columns_scanned++ );
+	ll bound = cv[u]-alpha[v]-beta[u];
+	if ( 0LL <= bound and bound < slack[u] ) {
+	  slack[u] = bound;
+	  nhbor[u] = v;
 	}
       }
-    
-    for ( int u: admissibles ) {
-      label_U[u] = true;
-      label_V[mate_U[u]] = true;
-      parent[mate_U[u]] = nhbor[u];
-      update_slack( mate_U[u] );
-    }    
+    COUNT( perf_end( perf.update_slack ) );
+
   }
-  
-}
 
-void initialize_search() {
+  // update_slack for the rows vs[0..count), fused: the columns are
+  // scanned in tiles and every row of the block goes over a tile while
+  // its slack, beta and nhbor are in L1. For each u the rows still come
+  // in order, so ties go to the same v as with one call per row.
+  // Rows that are not resident in c (file, points, caller) or pruned
+  // rows fall back to one call per row.
+  void update_slack_block( const int* vs, int count ) {
 
-  nhbor = vector<int>(N,-1);
-  parent = vector<int>(N,-1);
-  slack = vector<ll>(N,numeric_limits<ll>::max());
-  label_V = vector<bool>(N,false);
-  label_U = vector<bool>(N,false);
-  
-}
+    if ( file or points or caller or not cand.empty() or count == 1 ) {
+      for ( int i = 0; i < count; i++ ) update_slack( vs[i] );
+      return;
+    }
 
-void initialize_alpha_beta() {
+    COUNT( perf_begin( perf.update_slack ) );
+    COUNT( counters.update_slack_calls += count );
+    const ll* cv[UPDATE_SLACK_ROWS];
+    ll av[UPDATE_SLACK_ROWS];
+    for ( int i = 0; i < count; i++ ) {
+      cv[i] = c[vs[i]];
+      av[i] = alpha[vs[i]];
+    }
 
-  mate_V = vector<int>(N,-1);
-  mate_U = vector<int>(N,-1);
-  alpha = vector<ll>(N,0LL);
-  beta = vector<ll>(N);
-  for ( int u = 0; u < N; u++ )
-    beta[u] = min_col[u];
-  
-}
+    for ( int from = 0; from < N; from += UPDATE_SLACK_TILE ) {
+      int to = min( N, from+UPDATE_SLACK_TILE );
+      for ( int i = 0; i < count; i++ )
+	for ( int u = from; u < to; u++ )
+	  if ( unlabelled_U( u ) ) {
+	    COUNT( counters.columns_scanned++ );
+	    ll bound = cv[i][u]-av[i]-beta[u];
+	    if ( 0LL <= bound and bound < slack[u] ) {
+	      slack[u] = bound;
+	      nhbor[u] = vs[i];
+	    }
+	  }
+    }
+    COUNT( perf_end( perf.update_slack ) );
 
-void hungarian_algorithm() {
-  
-  initialize_alpha_beta();
-  
-  for ( int i = 0; i < N; i++ ) {
-    initialize_search();
-    
-    // start with unmatched v in V
-    for ( int v = 0; v < N; v++ )
-      if ( unmatched_V( v ) ) {
-	label_V[v] = true;
-	update_slack( v );
+  }
+
+  ll update_alpha_beta() {
+
+    COUNT( perf_begin( perf.update_alpha_beta ) );
+    COUNT( counters.alpha_beta_columns += N );
+    ll theta = numeric_limits<ll>::max();
+
+    // for unlabelled u in U
+    for ( int u = 0; u < N; u++ )
+      if ( unlabelled_U( u ) )
+	theta = min( theta, slack[u] );
+
+    // skip if theta == 0 (no update needed)
+    COUNT( theta > 0LL ? counters.theta_steps++ : counters.zero_theta_steps++ );
+    if ( theta > 0LL ) {
+
+      // integrality is ensured
+      theta /= 2LL;
+
+      COUNT( counters.alpha_beta_columns += N );
+      for ( int i = 0; i < N; i++ ) {
+	if ( label_V[i] ) alpha[i] += theta;
+	else alpha[i] -= theta;
+	if ( label_U[i] ) beta[i] -= theta;
+	else beta[i] += theta;
       }
-    
-    int u = search_augmenting_alternating_path();
-    
-    augment( nhbor[u], u );
+    }
+    COUNT( perf_end( perf.update_alpha_beta ) );
+
+    return theta;
   }
-  
-}
 
-void read_input() {
-  
-  cin >> N;
-  
-  c = vector<vector<ll>>(N,vector<ll>(N));
-  min_col = vector<ll>(N,numeric_limits<ll>::max());
-  
-  for ( int v = 0; v < N; v++ )
-    for ( int u = 0; u < N; u++ ) {
-      cin >> c[v][u];
-      
-      // multiply by 2LL to ensure integrality
-      c[v][u] *= 2LL;
-      min_col[u] = min( min_col[u], c[v][u] );
+  // -1 if the search was stopped (see expired and cancel_requested)
+  int search_augmenting_alternating_path() {
+
+    while ( true ) {
+      if ( expired() or cancel_requested() ) return -1;
+      ll theta = update_alpha_beta();
+
+      vector<int> admissibles = vector<int>();
+
+      // for unlabelled u in U
+      for ( int u = 0; u < N; u++ )
+	if ( unlabelled_U( u ) ) {
+	  slack[u] -= 2LL*theta;
+	  if ( admissible_U( u ) ) {
+	    // unlabelled, admissible and unmatched => path found
+	    if ( unmatched_U( u ) ) return u;
+	    else admissibles.push_back( u );
+	  }
+	}
+
+      // let the kernel start reading the rows about to be scanned
+      if ( file )
+	for ( int u: admissibles ) file->prefetch( mate_U[u] );
+
+      // admissible columns have zero slack, which no row can lower, so
+      // all of them are labelled first and their rows scanned in blocks;
+      // the rows of the first block are requested before the labelling,
+      // those of block b+1 before block b is scanned
+      int block[UPDATE_SLACK_ROWS], count = 0, size = int( admissibles.size() );
+      for ( int i = 0; i < min( PREFETCH_AHEAD, size ); i++ )
+	prefetch_row( mate_U[admissibles[i]] );
+      for ( int u: admissibles ) {
+	COUNT( counters.admissibles++ );
+	COUNT( counters.labelled++ );
+	label_U[u] = true;
+	label_V[mate_U[u]] = true;
+	parent[mate_U[u]] = nhbor[u];
+      }
+      for ( int i = 0; i < size; i++ ) {
+	block[count++] = mate_U[admissibles[i]];
+	if ( count == UPDATE_SLACK_ROWS ) {
+	  for ( int j = i+1; j < min( i+1+PREFETCH_AHEAD, size ); j++ )
+	    prefetch_row( mate_U[admissibles[j]] );
+	  update_slack_block( block, count );
+	  count = 0;
+	}
+      }
+      if ( count ) update_slack_block( block, count );
     }
-  
-}
 
-int main(int argc, char* argv[]) {
-  
-  ios::sync_with_stdio(false);
-  cin.tie(nullptr);
+  }
+
+  void initialize_search() {
 
-  bool match = false;
-  if ( argc > 1 ) {
-    string opt = argv[1];
-    if ( opt == "-m" or opt == "--match" )
-      match = true;
+    nhbor.assign( N, -1 );
+    parent.assign( N, -1 );
+    slack.assign( N, numeric_limits<ll>::max() );
+    label_V.assign( N, false );
+    label_U.assign( N, false );
+
+  }
+
+  void initialize_alpha_beta() {
+
+    mate_V.assign( N, -1 );
+    mate_U.assign( N, -1 );
+    alpha.assign( N, 0LL );
+    beta.assign( min_col.begin(), min_col.end() );
+
+  }
+
+  // start from feasible duals and a matching of tight edges that were
+  // computed for an instance differing only in the rows marked changed:
+  // those rows get row-reduced alphas (beta is shared, so all reduced
+  // costs stay even) and lose their match
+  void warm_start( const vector<int>& mate, const vector<ll>& a,
+		   const vector<ll>& b, const vector<bool>& changed ) {
+
+    mate_V = mate;
+    alpha = a;
+    beta = b;
+    mate_U.assign( N, -1 );
+    for ( int v = 0; v < N; v++ ) {
+      if ( changed[v] ) {
+	const ll* cv = row( v );
+	ll reduced = numeric_limits<ll>::max();
+	if ( not cand.empty() )
+	  for ( int u: cand[v] ) reduced = min( reduced, cv[u]-beta[u] );
+	else
+	  for ( int u = 0; u < N; u++ ) reduced = min( reduced, cv[u]-beta[u] );
+	alpha[v] = reduced;
+	mate_V[v] = -1;
+      } else mate_U[mate_V[v]] = v;
+    }
+
+  }
+
+  // the deadline has passed (pruned solves always run to the end,
+  // their duals are only feasible on the candidate edges)
+  bool expired() const {
+    return has_deadline and cand.empty() and Clock::now() >= deadline;
+  }
+
+  // a relaxed load, cheap enough for every theta round
+  bool cancel_requested() const {
+    return cancel and cancel->load( memory_order_relaxed );
+  }
+
+  // ceil(x/2): the duals are doubled and the optimum is integral
+  static ll half_up( ll x ) {
+    return x/2LL+( x > 0LL and x%2LL != 0LL ? 1LL : 0LL );
   }
 
-  read_input();
+  // progress callback with the current dual objective, after an
+  // augmentation (sum is alpha+beta summed over all rows and columns)
+  void report_progress( int matched, ll sum ) const {
+    progress( matched, half_up( sum ) );
+  }
+
+  // warm: mate_V, mate_U, alpha and beta were set by warm_start
+  void hungarian_algorithm( bool warm = false ) {
+
+    begin_search( warm );
+    continue_search( Clock::time_point::max() );
+
+  }
+
+  //////////////////////////////////////////////////////////////////////
+  //
+  // Resumable search: between two outer iterations the whole state is
+  // the matching and the duals, so the search can be run in slices
+  // (see SolvePool); hungarian_algorithm is one unbounded slice.
+  //
+  //////////////////////////////////////////////////////////////////////
 
-  hungarian_algorithm();
+  int next_row = 0;            // outer iteration to run next
 
-  if ( match ) { // output assignment itself
+  void begin_search( bool warm ) {
+
+    Clock::time_point t0 = Clock::now();
+    perf_begin( perf.initialization );
+    if ( not warm ) initialize_alpha_beta();
+    next_row = 0;
     for ( int v = 0; v < N; v++ )
-      cout << mate_V[v] << endl;
-  } else {       // output optimal assignment cost
-    ll opt_cost = 0LL;
-    for ( int i = 0; i < N; i++ )
-      opt_cost += alpha[i]+beta[i];
-    cout << opt_cost/2LL << endl;
+      if ( not unmatched_V( v ) ) next_row++;
+    perf_end( perf.initialization );
+    timings.initialization = seconds_since( t0 );
+    timings.search = 0.0;
+    stopped = cancelled = false;
+
   }
-  
-  return 0;
-  
-}
+
+  // runs outer iterations until the search ends (true) or until; the
+  // first one always runs, so every slice makes progress
+  bool continue_search( Clock::time_point until ) {
+
+    Clock::time_point t0 = Clock::now();
+    perf_begin( perf.search );
+    for ( int i = next_row; i < N; i++ ) {
+      if ( i > next_row and Clock::now() >= until ) {
+	next_row = i;
+	break;
+      }
+      initialize_search();
+      COUNT( count_search( N-i ) );
+
+      // start with unmatched v in V
+      for ( int v = 0; v < N; v++ )
+	if ( unmatched_V( v ) ) {
+	  label_V[v] = true;
+	  update_slack( v );
+	}
+
+      int u = search_augmenting_alternating_path();
+      if ( u == -1 and cancel_requested() ) {
+	cancelled = true;
+	break;
+      }
+      if ( u == -1 ) {
+	stopped = true;
+	matched_at_stop = i;
+	complete_greedily();
+	break;
+      }
+
+      augment( nhbor[u], u );
+      COUNT( count_augment() );
+
+      if ( progress ) {
+	ll sum = 0LL;
+	for ( int j = 0; j < N; j++ )
+	  sum += alpha[j]+beta[j];
+	report_progress( i+1, sum );
+      }
+      if ( i+1 == N ) next_row = N;
+    }
+    perf_end( perf.search );
+    timings.search += seconds_since( t0 );
+    return next_row >= N or stopped or cancelled;
+
+  }
+
+  //////////////////////////////////////////////////////////////////////
+  //
+  // Optimality certificate: mate_V is a permutation, the duals are
+  // feasible (c[v][u] >= alpha[v]+beta[u]) and every matched edge is
+  // tight. One pass over c, rows split among threads; the per-row
+  // min(c[v][u]-beta[u]) is a plain reduction the compiler vectorizes.
+  //
+  //////////////////////////////////////////////////////////////////////
+
+  // first row in [from,to) that violates feasibility or tightness, or to
+  int verify_rows( int from, int to ) const {
+
+    vector<ll> buf;
+    for ( int v = from; v < to; v++ ) {
+      const ll* row = this->row( v, buf );
+      const ll* b = beta.data();
+      ll reduced = numeric_limits<ll>::max();
+      for ( int u = 0; u < N; u++ )
+	if ( row[u] < forbidden ) reduced = min( reduced, row[u]-b[u] );
+      if ( reduced < alpha[v] or row[mate_V[v]]-b[mate_V[v]] != alpha[v] )
+	return v;
+    }
+    return to;
+
+  }
+
+  // returns an empty string if the certificate holds, else the reason
+  string verify_certificate( int threads = 1 ) const {
+
+    if ( int( mate_V.size() ) != N ) return "matching has wrong size";
+
+    vector<bool> seen( N, false );
+    for ( int v = 0; v < N; v++ ) {
+      int u = mate_V[v];
+      if ( u < 0 or u >= N or seen[u] )
+	return "matching is not a permutation at row "+to_string( v );
+      seen[u] = true;
+    }
+
+    threads = max( 1, min( threads, N ) );
+    vector<int> from( threads+1 ), bad( threads );
+    for ( int t = 0; t <= threads; t++ )
+      from[t] = int( ll( N )*t/threads );
+
+    vector<thread> pool;
+    for ( int t = 1; t < threads; t++ )
+      pool.emplace_back( [this,&from,&bad,t,threads]() {
+	numa_pin( t, threads );
+	bad[t] = verify_rows( from[t], from[t+1] );
+      } );
+    bad[0] = verify_rows( from[0], from[1] );
+    for ( thread& th: pool ) th.join();
+
+    for ( int t = 0; t < threads; t++ )
+      if ( bad[t] != from[t+1] ) {
+	int v = bad[t];
+	vector<ll> buf;
+	const ll* cv = row( v, buf );
+	for ( int u = 0; u < N; u++ )
+	  if ( cv[u] < forbidden and cv[u] < alpha[v]+beta[u] )
+	    return "dual infeasible at ("+to_string( v )+","+to_string( u )+")";
+	return "matched edge of row "+to_string( v )+" is not tight";
+      }
+
+    return "";
+
+  }
+
+  //////////////////////////////////////////////////////////////////////
+  //
+  // Candidate pruning: solve on the k cheapest edges of every row (plus
+  // (v,v), so that a perfect matching always exists), then check the
+  // duals against the full matrix. Rows with a negative reduced cost
+  // get those edges added and are re-solved from the current duals
+  // (see warm_start) until no row has one, which is the certificate.
+  //
+  //////////////////////////////////////////////////////////////////////
+
+  void select_candidates( int k ) {
+
+    cand.assign( N, vector<int>() );
+    vector<pair<ll,int>> order( N );
+    for ( int v = 0; v < N; v++ ) {
+      const ll* cv = row( v );
+      for ( int u = 0; u < N; u++ )
+	order[u] = make_pair( cv[u], u );
+      nth_element( order.begin(), order.begin()+( k-1 ), order.end() );
+      bool diagonal = false;
+      for ( int i = 0; i < k; i++ ) {
+	cand[v].push_back( order[i].second );
+	diagonal = diagonal or order[i].second == v;
+      }
+      if ( not diagonal ) cand[v].push_back( v );
+      sort( cand[v].begin(), cand[v].end() );
+      prune_edges += ll( cand[v].size() );
+    }
+
+  }
+
+  // adds the columns of row v with a negative reduced cost to cand[v]
+  bool expand_row( int v ) {
+
+    const ll* cv = row( v );
+    size_t before = cand[v].size();
+    for ( int u = 0; u < N; u++ )
+      if ( cv[u]-alpha[v]-beta[u] < 0LL )
+	cand[v].push_back( u );
+    if ( cand[v].size() == before ) return false;
+    prune_edges += ll( cand[v].size()-before );
+    sort( cand[v].begin(), cand[v].end() );
+    return true;
+
+  }
+
+  void pruned_algorithm( int k ) {
+
+    prune_rounds = 0;
+    prune_edges = 0LL;
+    if ( k <= 0 or k >= N ) {
+      hungarian_algorithm();
+      return;
+    }
+
+    Clock::time_point t0 = Clock::now();
+    select_candidates( k );
+    double initialization = seconds_since( t0 ), search = 0.0;
+
+    hungarian_algorithm();
+    while ( not cancelled ) {
+      prune_rounds++;
+      initialization += timings.initialization;
+      search += timings.search;
+
+      t0 = Clock::now();
+      vector<bool> changed( N, false );
+      bool any = false;
+      for ( int v = 0; v < N; v++ )
+	if ( expand_row( v ) ) changed[v] = any = true;
+      search += seconds_since( t0 );
+      if ( not any ) break;
+
+      warm_start( mate_V, alpha, beta, changed );
+      hungarian_algorithm( true );
+    }
+    cand.clear();
+    timings.initialization = initialization;
+    timings.search = search;
+
+  }
+
+  ll optimal_cost() const {
+
+    ll opt_cost = 0LL;
+    for ( int i = 0; i < N; i++ )
+      opt_cost += alpha[i]+beta[i];
+    return opt_cost/2LL;
+
+  }
+
+  //////////////////////////////////////////////////////////////////////
+  //
+  // Anytime mode: when the deadline stops the search, the matched
+  // edges are tight and the duals feasible, so they give a lower bound
+  // on the optimum (see lower_bound); the unmatched rows are then given the
+  // free column of least reduced cost, one row at a time.
+  //
+  //////////////////////////////////////////////////////////////////////
+
+  void complete_greedily() {
+
+    vector<int> free_U;
+    for ( int u = 0; u < N; u++ )
+      if ( unmatched_U( u ) ) free_U.push_back( u );
+
+    for ( int v = 0; v < N; v++ )
+      if ( unmatched_V( v ) ) {
+	const ll* cv = row( v );
+	int best = 0;
+	for ( int i = 1; i < int( free_U.size() ); i++ )
+	  if ( cv[free_U[i]]-beta[free_U[i]] < cv[free_U[best]]-beta[free_U[best]] )
+	    best = i;
+	mate_V[v] = free_U[best];
+	mate_U[free_U[best]] = v;
+	free_U[best] = free_U.back();
+	free_U.pop_back();
+      }
+
+  }
+
+  // cost of mate_V: the optimum unless the search was stopped
+  ll assignment_cost() const {
+
+    if ( not stopped ) return optimal_cost();
+    ll total = 0LL;
+    vector<ll> buf;
+    for ( int v = 0; v < N; v++ )
+      total += row( v, buf )[mate_V[v]];
+    return total/2LL;
+
+  }
+
+  // dual lower bound on the optimum (rounded up, the optimum is
+  // integral); each alpha[v] is raised to min(c[v][u]-beta[u]), which
+  // keeps the duals feasible and only tightens the bound
+  ll lower_bound() const {
+
+    ll total = 0LL;
+    vector<ll> buf;
+    for ( int v = 0; v < N; v++ ) {
+      const ll* cv = row( v, buf );
+      ll reduced = numeric_limits<ll>::max();
+      for ( int u = 0; u < N; u++ )
+	reduced = min( reduced, cv[u]-beta[u] );
+      total += reduced+beta[v];
+    }
+    return half_up( total );
+
+  }
+
+  static uint64_t hash_step( uint64_t h, ll x ) {
+    h = ( h ^ uint64_t( x ) )*0x9E3779B97F4A7C15ULL;
+    return h ^ ( h >> 29 );
+  }
+
+  //////////////////////////////////////////////////////////////////////
+  //
+  // Text input. A regular file on the standard input is mmapped and
+  // cut at newlines into one chunk per thread (of PARSE_CHUNK bytes at
+  // least). A first parallel pass counts the numbers of each chunk,
+  // which gives the index of its first cost, and a second one parses
+  // them straight into c, so that each thread first-touches its own
+  // rows, with a min_col of its own merged at the end. Rows split
+  // between two chunks are hashed afterwards. Pipes are parsed block
+  // by block as the data arrives (read_stream), after the bytes that
+  // InputDecoder::open already read from them (prefix).
+  //
+  //////////////////////////////////////////////////////////////////////
+
+  static const size_t PARSE_CHUNK = size_t( 1 ) << 20;
+
+  // returns an empty string on success, else the reason
+  string read_input( int threads = 1, const string& prefix = "" ) {
+
+    file.reset();
+    points.reset();
+    caller.reset();
+
+    struct stat st;
+    off_t start = lseek( STDIN_FILENO, 0, SEEK_CUR );
+    if ( start < 0 or fstat( STDIN_FILENO, &st ) < 0 or not S_ISREG( st.st_mode ) or st.st_size <= start )
+      return read_stream( prefix );
+    size_t size = size_t( st.st_size );
+    void* map = mmap( nullptr, size, PROT_READ, MAP_PRIVATE, STDIN_FILENO, 0 );
+    if ( map == MAP_FAILED ) return read_stream( prefix );
+    madvise( map, size, MADV_SEQUENTIAL );
+
+    const char* text = (const char*)( map );
+    string error = parse_text( text+start, text+size, threads );
+    munmap( map, size );
+    return error;
+
+  }
+
+  // a pipe: blocks are parsed as they arrive, and the number cut by
+  // the end of a block is carried over to the next one
+  string read_stream( const string& prefix ) {
+
+    vector<char> buf( max( PARSE_CHUNK, 2*prefix.size() ) );
+    vector<char> hashed;
+    size_t have = prefix.size();
+    memcpy( buf.data(), prefix.data(), have );
+    ll k = -1;              // next cost, -1 before N
+    bool eof = false;
+    while ( not eof ) {
+      ssize_t r = read( STDIN_FILENO, buf.data()+have, buf.size()-have );
+      if ( r < 0 and errno == EINTR ) continue;
+      if ( r < 0 ) return string( "read error: " )+strerror( errno );
+      eof = r == 0;
+      have += size_t( r );
+
+      size_t complete = have;
+      if ( not eof ) {
+	while ( complete > 0 and not is_space( buf[complete-1] ) ) complete--;
+	if ( complete == 0 ) {
+	  if ( have == buf.size() ) buf.resize( 2*buf.size() );
+	  continue;
+	}
+      }
+      const char* p = buf.data();
+      const char* end = p+complete;
+      if ( k < 0 ) {
+	while ( p < end and is_space( *p ) ) p++;
+	if ( p == end and not eof ) {     // only blanks so far
+	  have -= complete;
+	  memmove( buf.data(), buf.data()+complete, have );
+	  continue;
+	}
+	if ( not start_text( p, end ) ) return "bad N";
+	if ( N == 0 ) return "";
+	hashed.assign( N, 0 );
+	k = 0;
+      }
+      k = parse_chunk( p, end, k, min_col, hashed );
+      if ( k < 0 ) return "malformed cost";
+      have -= complete;
+      memmove( buf.data(), buf.data()+complete, have );
+    }
+    if ( k < 0 ) return "bad N";
+    if ( k < ll( N )*N )
+      return "expected "+to_string( ll( N )*N )+" costs, read "+to_string( k );
+    hash_split_rows( hashed );
+    return "";
+
+  }
+
+  static bool is_space( char ch ) { return ch == ' ' or ( ch >= '\t' and ch <= '\r' ); }
+
+  // runs f( t ) for t < threads, each on its NUMA part (see numa_pin)
+  template<typename F>
+  static void parallel( int threads, F f ) {
+    vector<thread> pool;
+    for ( int t = 1; t < threads; t++ )
+      pool.emplace_back( [&f,t,threads]() {
+	numa_pin( t, threads );
+	f( t );
+      } );
+    f( 0 );
+    for ( thread& th: pool ) th.join();
+  }
+
+  // reads N and allocates the instance; false if N is malformed
+  bool start_text( const char*& p, const char* end ) {
+
+    while ( p < end and is_space( *p ) ) p++;
+    ll n = 0;
+    const char* digits = p;
+    while ( p < end and *p >= '0' and *p <= '9' and n <= numeric_limits<int>::max() )
+      n = 10*n+( *p++-'0' );
+    if ( p == digits or n > numeric_limits<int>::max() or ( p < end and not is_space( *p ) ) )
+      return false;
+
+    N = int( n );
+    c.assign( N );
+    min_col.assign( N, numeric_limits<ll>::max() );
+    row_hash.assign( N, 0ULL );
+    return true;
+
+  }
+
+  string parse_text( const char* p, const char* end, int threads ) {
+
+    if ( not start_text( p, end ) ) return "bad N";
+    if ( N == 0 ) return "";
+
+    threads = int( max( 1LL, min( ll( threads ), ll( end-p )/ll( PARSE_CHUNK ) ) ) );
+    vector<const char*> cut( threads+1, end );
+    cut[0] = p;
+    for ( int t = 1; t < threads; t++ ) {
+      const char* q = max( cut[t-1], p+( end-p )*t/threads );
+      const char* nl = (const char*)( memchr( q, '\n', size_t( end-q ) ) );
+      cut[t] = nl ? nl+1 : end;
+    }
+
+    vector<ll> first( threads+1, 0LL );
+    parallel( threads, [&]( int t ) {
+      ll k = 0;
+      bool in = false;
+      for ( const char* q = cut[t]; q < cut[t+1]; q++ ) {
+	bool number = not is_space( *q );
+	if ( number and not in ) k++;
+	in = number;
+      }
+      first[t+1] = k;
+    } );
+    for ( int t = 0; t < threads; t++ ) first[t+1] += first[t];
+    if ( first[threads] < ll( N )*N )
+      return "expected "+to_string( ll( N )*N )+" costs, read "+to_string( first[threads] );
+
+    vector<vector<ll>> mins( threads );
+    vector<char> hashed( N, 0 ), ok( threads, 1 );
+    parallel( threads, [&]( int t ) {
+      mins[t].assign( N, numeric_limits<ll>::max() );
+      ok[t] = parse_chunk( cut[t], cut[t+1], first[t], mins[t], hashed ) >= 0;
+    } );
+    for ( int t = 0; t < threads; t++ )
+      if ( not ok[t] ) return "malformed cost";
+
+    for ( int t = 0; t < threads; t++ )
+      for ( int u = 0; u < N; u++ )
+	min_col[u] = min( min_col[u], mins[t][u] );
+    hash_split_rows( hashed );
+    return "";
+
+  }
+
+  // rows that no single chunk held whole (see parse_chunk)
+  void hash_split_rows( const vector<char>& hashed ) {
+    for ( int v = 0; v < N; v++ ) {
+      if ( hashed[v] ) continue;
+      uint64_t h = uint64_t( N );
+      for ( int u = 0; u < N; u++ ) h = hash_step( h, c[v][u]/2LL );
+      row_hash[v] = h;
+    }
+  }
+
+  // parses the costs in [p,end), the first of which is cost k in
+  // row-major order, and returns the index after the last one (costs
+  // past N*N are ignored), or -1 if one is not an integer
+  ll parse_chunk( const char* p, const char* end, ll k, vector<ll>& mins, vector<char>& hashed ) {
+
+    int v = int( k/N ), u = int( k%N );
+    bool whole = u == 0;         // row v starts in this chunk
+    uint64_t h = uint64_t( N );
+    while ( v < N ) {
+      while ( p < end and is_space( *p ) ) p++;
+      if ( p == end ) break;
+      bool negative = *p == '-';
+      if ( *p == '-' or *p == '+' ) p++;
+      const char* digits = p;
+      ll x = 0;
+      while ( p < end and *p >= '0' and *p <= '9' ) x = 10*x+( *p++-'0' );
+      if ( p == digits or ( p < end and not is_space( *p ) ) ) return -1;
+      if ( negative ) x = -x;
+
+      h = hash_step( h, x );
+      ll* cv = c[v];
+      cv[u] = 2LL*x;
+      mins[u] = min( mins[u], cv[u] );
+      if ( ++u == N ) {
+	if ( whole ) {
+	  row_hash[v] = h;
+	  hashed[v] = 1;
+	}
+	v++;
+	u = 0;
+	whole = true;
+	h = uint64_t( N );
+      }
+    }
+    return ll( v )*N+u;
+
+  }
+
+  // same as read_input, from a row-major n x n array
+  void load( int n, const ll* costs ) {
+    load_strided<ll>( n, (const char*)( costs ), 8*size_t( n ) );
+  }
+
+  // same, from n rows of n T's starting stride bytes apart
+  template<typename T>
+  void load_strided( int n, const char* costs, size_t stride ) {
+
+    N = n;
+    file.reset();
+    points.reset();
+    caller.reset();
+    forbidden = numeric_limits<ll>::max();
+    c.assign( N );
+    min_col.assign( N, numeric_limits<ll>::max() );
+    row_hash.assign( N, 0ULL );
+
+    for ( int v = 0; v < N; v++ ) {
+      const T* cv = (const T*)( costs+stride*v );
+      uint64_t h = uint64_t( N );
+      for ( int u = 0; u < N; u++ ) {
+	h = hash_step( h, ll( cv[u] ) );
+	c[v][u] = 2LL*ll( cv[u] );
+	min_col[u] = min( min_col[u], c[v][u] );
+      }
+      row_hash[v] = h;
+    }
+
+  }
+
+  // same, without copying: the rows (int64 if wide, else int32) are read
+  // from costs during the solve (see CallerMatrix), so they must not
+  // change until it returns. There are no row hashes (no result cache).
+  void borrow( int n, const char* costs, size_t stride, bool wide ) {
+
+    N = n;
+    file.reset();
+    points.reset();
+    if ( not caller ) caller.reset( new CallerMatrix() );
+    caller->N = N;
+    caller->costs = costs;
+    caller->stride = stride;
+    caller->wide = wide;
+    caller->buf.resize( N );
+    forbidden = numeric_limits<ll>::max();
+    min_col.assign( N, numeric_limits<ll>::max() );
+    row_hash.clear();
+
+    for ( int v = 0; v < N; v++ ) {
+      const ll* cv = caller->row( v );
+      for ( int u = 0; u < N; u++ )
+	min_col[u] = min( min_col[u], cv[u] );
+    }
+
+  }
+
+  // out-of-core instance: one sequential pass for min_col and the row
+  // hashes; returns an empty string on success, else the reason
+  string open_matrix( const string& path, size_t cache_bytes ) {
+
+    points.reset();
+    caller.reset();
+    file.reset( new MatrixFile() );
+    string error = file->open_file( path, cache_bytes );
+    if ( not error.empty() ) return error;
+
+    N = file->N;
+    c.clear();
+    min_col.assign( N, numeric_limits<ll>::max() );
+    row_hash.assign( N, 0ULL );
+
+    file->advise( true );
+    vector<ll> buf;
+    for ( int v = 0; v < N; v++ ) {
+      const ll* cv = row( v, buf );
+      uint64_t h = uint64_t( N );
+      for ( int u = 0; u < N; u++ ) {
+	h = hash_step( h, cv[u]/2LL );
+	min_col[u] = min( min_col[u], cv[u] );
+      }
+      row_hash[v] = h;
+    }
+    file->advise( false );
+    return "";
+
+  }
+
+  // implicit instance from two point sets on the standard input;
+  // returns an empty string on success, else the reason
+  string read_points( const string& metric, double scale ) {
+
+    file.reset();
+    caller.reset();
+    points.reset( new PointSet() );
+    string error = points->read( cin, metric, scale );
+    if ( not error.empty() ) return error;
+
+    N = points->N;
+    c.clear();
+    min_col.assign( N, numeric_limits<ll>::max() );
+    row_hash.assign( N, 0ULL );
+
+    for ( int v = 0; v < N; v++ ) {
+      const ll* cv = row( v );
+      uint64_t h = uint64_t( N );
+      for ( int u = 0; u < N; u++ ) {
+	h = hash_step( h, cv[u]/2LL );
+	min_col[u] = min( min_col[u], cv[u] );
+      }
+      row_hash[v] = h;
+    }
+    return "";
+
+  }
+
+};
+
+////////////////////////////////////////////////////////////////////////
+//
+// Specialized solver for small fixed N (1 <= N <= FIXED_MAX_N)
+//
+// Same alpha-beta algorithm as above, but with std::array storage,
+// the labels of V and U kept as bitmasks in a single register and
+// compile-time trip counts, so that the slack update is unrolled
+// and branch free. It produces exactly the same mate_V, alpha and
+// beta as hungarian_algorithm().
+//
+////////////////////////////////////////////////////////////////////////
+
+const int FIXED_MAX_N = 64;
+
+template<int n, typename Cost>
+struct HungarianFixed {
+
+  typedef unsigned long long mask;
+  static const mask all = ~0ULL >> ( 64-n );
+
+  array<array<Cost,n>,n> c;
+  array<int,n> mate_V,mate_U,nhbor,parent;
+  array<Cost,n> alpha,beta,slack;
+  mask label_V,label_U;
+
+  static int bit( mask m ) { return __builtin_ctzll( m ); }
+
+  void augment( int v, int exposed_u ) {
+
+    while ( true ) {
+      int aux = mate_V[v];
+
+      COUNT( counters.path++ );
+      mate_V[v] = exposed_u;
+      mate_U[exposed_u] = v;
+
+      if ( parent[v] == -1 ) break;
+      exposed_u = aux;
+      v = parent[v];
+    }
+
+  }
+
+  void update_slack( int v ) {
+
+    const array<Cost,n>& row = c[v];
+    const Cost a = alpha[v];
+
+    COUNT( perf_begin( perf.update_slack ) );
+    COUNT( counters.update_slack_calls++ );
+    COUNT( counters.columns_scanned += __builtin_popcountll( ~label_U & all ) );
+
+    // a labelled u has slack 0 (it was admissible), so 0 <= bound <
+    // slack[u] already leaves it out; the masks keep the loop branch
+    // free and vectorizable
+#pragma GCC ivdep
+    for ( int u = 0; u < n; u++ ) {
+      Cost bound = row[u]-a-beta[u];
+      Cost better = -Cost( ( Cost(0) <= bound ) & ( bound < slack[u] ) );
+      slack[u] ^= ( slack[u]^bound ) & better;
+      nhbor[u] ^= ( nhbor[u]^v ) & int( better );
+    }
+    COUNT( perf_end( perf.update_slack ) );
+
+  }
+
+  Cost update_alpha_beta() {
+
+    COUNT( perf_begin( perf.update_alpha_beta ) );
+    COUNT( counters.alpha_beta_columns += n );
+    Cost theta = numeric_limits<Cost>::max();
+
+    // for unlabelled u in U
+    for ( mask m = ~label_U & all; m; m &= m-1 )
+      theta = min( theta, slack[bit( m )] );
+
+    COUNT( theta > Cost(0) ? counters.theta_steps++ : counters.zero_theta_steps++ );
+    if ( theta > Cost(0) ) {
+      theta /= Cost(2);
+
+      COUNT( counters.alpha_beta_columns += n );
+      for ( int i = 0; i < n; i++ ) {
+	alpha[i] += ( label_V >> i & 1ULL ) ? theta : -theta;
+	beta[i] += ( label_U >> i & 1ULL ) ? -theta : theta;
+      }
+    }
+    COUNT( perf_end( perf.update_alpha_beta ) );
+
+    return theta;
+  }
+
+  int search_augmenting_alternating_path() {
+
+    while ( true ) {
+      Cost theta = update_alpha_beta();
+
+      mask admissibles = 0ULL;
+
+      // for unlabelled u in U
+      for ( mask m = ~label_U & all; m; m &= m-1 ) {
+	int u = bit( m );
+	slack[u] -= Cost(2)*theta;
+	if ( slack[u] == Cost(0) ) {
+	  if ( mate_U[u] == -1 ) return u;
+	  else admissibles |= 1ULL << u;
+	}
+      }
+
+      for ( ; admissibles; admissibles &= admissibles-1 ) {
+	int u = bit( admissibles );
+	int v = mate_U[u];
+	COUNT( counters.admissibles++ );
+	COUNT( counters.labelled++ );
+	label_U |= 1ULL << u;
+	label_V |= 1ULL << v;
+	parent[v] = nhbor[u];
+	update_slack( v );
+      }
+    }
+
+  }
+
+  // beta must hold the column minima
+  void hungarian_algorithm() {
+
+    mate_V.fill( -1 );
+    mate_U.fill( -1 );
+    alpha.fill( Cost(0) );
+
+    // nhbor[u] is set before it is read (slack[u] starts above any
+    // bound) and parent[v] when v is labelled, so they are not cleared
+    for ( int i = 0; i < n; i++ ) {
+      slack.fill( numeric_limits<Cost>::max() );
+      label_V = label_U = 0ULL;
+      COUNT( count_search( n-i ) );
+
+      // start with unmatched v in V
+      for ( int v = 0; v < n; v++ )
+	if ( mate_V[v] == -1 ) {
+	  label_V |= 1ULL << v;
+	  parent[v] = -1;
+	  update_slack( v );
+	}
+
+      int u = search_augmenting_alternating_path();
+
+      augment( nhbor[u], u );
+      COUNT( count_augment() );
+    }
+
+  }
+
+  // solve the instance of s (s.N == n) and store the result in s
+  static void run( HungarianSolver& s ) {
+
+    // allocated on first use: the 128 instantiations would otherwise
+    // add about 1MB of thread local storage to every thread
+    static thread_local unique_ptr<HungarianFixed> workspace;
+    if ( not workspace ) workspace.reset( new HungarianFixed() );
+    HungarianFixed& w = *workspace;
+
+    Clock::time_point t0 = Clock::now();
+    perf_begin( perf.initialization );
+    for ( int v = 0; v < n; v++ ) {
+      const ll* cv = s.row( v );
+      for ( int u = 0; u < n; u++ )
+	w.c[v][u] = Cost( cv[u] );
+    }
+    for ( int u = 0; u < n; u++ )
+      w.beta[u] = Cost( s.min_col[u] );
+    perf_end( perf.initialization );
+    s.timings.initialization = seconds_since( t0 );
+
+    t0 = Clock::now();
+    perf_begin( perf.search );
+    w.hungarian_algorithm();
+    perf_end( perf.search );
+    s.timings.search = seconds_since( t0 );
+
+    s.mate_V.assign( w.mate_V.begin(), w.mate_V.end() );
+    s.mate_U.assign( w.mate_U.begin(), w.mate_U.end() );
+    s.alpha.assign( w.alpha.begin(), w.alpha.end() );
+    s.beta.assign( w.beta.begin(), w.beta.end() );
+
+  }
+
+};
+
+typedef void (*fixed_solver)( HungarianSolver& );
+
+template<typename Cost, size_t... I>
+array<fixed_solver,FIXED_MAX_N+1> fixed_table( index_sequence<I...> ) {
+  return {{ nullptr, &HungarianFixed<int(I)+1,Cost>::run... }};
+}
+
+// dispatch tables indexed by N
+const array<fixed_solver,FIXED_MAX_N+1> fixed_ll =
+  fixed_table<ll>( make_index_sequence<FIXED_MAX_N>() );
+const array<fixed_solver,FIXED_MAX_N+1> fixed_int =
+  fixed_table<int>( make_index_sequence<FIXED_MAX_N>() );
+
+void fixed_algorithm( HungarianSolver& s ) {
+
+  // a fixed solve takes microseconds and does not poll the cancel
+  // flag, so a cancel is honoured before it starts or once it is done
+  s.stopped = s.cancelled = false;
+  if ( s.cancel_requested() ) {
+    s.cancelled = true;
+    return;
+  }
+
+  // 32 bit costs are safe if the duals cannot leave [-2^29,2^29]
+  ll max_abs = 0LL;
+  for ( int v = 0; v < s.N; v++ ) {
+    const ll* cv = s.row( v );
+    for ( int u = 0; u < s.N; u++ )
+      max_abs = max( max_abs, cv[u] < 0LL ? -cv[u] : cv[u] );
+  }
+
+  if ( max_abs*(2LL*s.N+2LL) < (1LL << 29) ) fixed_int[s.N]( s );
+  else fixed_ll[s.N]( s );
+  if ( s.cancel_requested() ) s.cancelled = true;
+
+}
+
+////////////////////////////////////////////////////////////////////////
+//
+// Packed column layout (AoSoA): the per-column state that the search
+// reads together (slack, beta, nhbor, mate_U and the label) is kept
+// in blocks of PACKED_WIDTH columns, so one block is a few contiguous
+// cache lines instead of five separate streams. Same algorithm and
+// same results as hungarian_algorithm(); "auto" uses it for N above
+// FIXED_MAX_N where PACKED_AUTO says it was faster (see bench.sh).
+//
+////////////////////////////////////////////////////////////////////////
+
+#ifdef __AVX512F__
+const int PACKED_WIDTH = 16;
+#else
+const int PACKED_WIDTH = 8;
+#endif
+// measured on x86-64 (SSE2, AVX2 and AVX-512 builds): 8-20%
+// less search time than dense for N = 1000-2000; other ISAs unmeasured
+#if defined( __x86_64__ )
+const bool PACKED_AUTO = true;
+#else
+const bool PACKED_AUTO = false;
+#endif
+
+template<int W>
+struct HungarianPacked {
+
+  struct Block {
+    ll slack[W], beta[W];
+    int nhbor[W], mate[W];
+    unsigned label;             // bit j: column j of the block is labelled
+  };
+
+  int N = 0, full = 0;          // full: blocks without padding
+  vector<Block> col;
+  vector<int> mate_V, parent;
+  vector<ll> alpha;
+  vector<bool> label_V;
+  unsigned padding = 0;         // label bits of the padding of the last block
+
+  Block& block( int u ) { return col[u/W]; }
+
+  void augment( int v, int exposed_u ) {
+
+    while ( true ) {
+      int aux = mate_V[v];
+
+      COUNT( counters.path++ );
+      mate_V[v] = exposed_u;
+      block( exposed_u ).mate[exposed_u%W] = v;
+
+      if ( parent[v] == -1 ) break;
+      exposed_u = aux;
+      v = parent[v];
+    }
+
+  }
+
+  void update_slack( int v, const ll* cv ) {
+
+    COUNT( perf_begin( perf.update_slack ) );
+    COUNT( counters.update_slack_calls++ );
+    const ll a = alpha[v];
+
+    // full blocks are branch free, the last one checks N
+    for ( int b = 0; b < full; b++ ) {
+      Block& k = col[b];
+      const ll* row = cv+b*W;
+      for ( int j = 0; j < W; j++ ) {
+	ll bound = row[j]-a-k.beta[j];
+	bool better = not ( k.label >> j & 1U ) and 0LL <= bound and bound < k.slack[j];
+	k.slack[j] = better ? bound : k.slack[j];
+	k.nhbor[j] = better ? v : k.nhbor[j];
+      }
+    }
+    for ( int u = full*W; u < N; u++ ) {
+      Block& k = block( u );
+      int j = u%W;
+      ll bound = cv[u]-a-k.beta[j];
+      if ( not ( k.label >> j & 1U ) and 0LL <= bound and bound < k.slack[j] ) {
+	k.slack[j] = bound;
+	k.nhbor[j] = v;
+      }
+    }
+    // padding columns are labelled, so they never count
+    COUNT( for ( Block& k: col ) counters.columns_scanned += W-__builtin_popcount( k.label ) );
+    COUNT( perf_end( perf.update_slack ) );
+
+  }
+
+  ll update_alpha_beta() {
+
+    COUNT( perf_begin( perf.update_alpha_beta ) );
+    COUNT( counters.alpha_beta_columns += N );
+    ll theta = numeric_limits<ll>::max();
+
+    // padding columns are labelled, so they never count
+    for ( Block& k: col )
+      for ( int j = 0; j < W; j++ )
+	theta = min( theta, ( k.label >> j & 1U ) ? numeric_limits<ll>::max() : k.slack[j] );
+
+    COUNT( theta > 0LL ? counters.theta_steps++ : counters.zero_theta_steps++ );
+    if ( theta > 0LL ) {
+      theta /= 2LL;
+
+      COUNT( counters.alpha_beta_columns += N );
+      for ( int v = 0; v < N; v++ )
+	alpha[v] += label_V[v] ? theta : -theta;
+      for ( Block& k: col )
+	for ( int j = 0; j < W; j++ )
+	  k.beta[j] += ( k.label >> j & 1U ) ? -theta : theta;
+    }
+    COUNT( perf_end( perf.update_alpha_beta ) );
+
+    return theta;
+  }
+
+  // -1 if the solve was cancelled
+  int search_augmenting_alternating_path( HungarianSolver& s ) {
+
+    vector<int> admissibles;
+    while ( true ) {
+      if ( s.cancel_requested() ) return -1;
+      ll theta = update_alpha_beta();
+
+      admissibles.clear();
+      for ( int b = 0; b < int( col.size() ); b++ ) {
+	Block& k = col[b];
+	for ( int j = 0; j < W; j++ )
+	  if ( not ( k.label >> j & 1U ) ) {
+	    k.slack[j] -= 2LL*theta;
+	    if ( k.slack[j] == 0LL ) {
+	      if ( k.mate[j] == -1 ) return b*W+j;
+	      admissibles.push_back( b*W+j );
+	    }
+	  }
+      }
+
+      // one row at a time: the row PREFETCH_AHEAD rows ahead
+      int size = int( admissibles.size() );
+      for ( int i = 0; i < min( PREFETCH_AHEAD, size ); i++ )
+	s.prefetch_row( block( admissibles[i] ).mate[admissibles[i]%W] );
+      for ( int i = 0; i < size; i++ ) {
+	if ( i+PREFETCH_AHEAD < size ) {
+	  int next = admissibles[i+PREFETCH_AHEAD];
+	  s.prefetch_row( block( next ).mate[next%W] );
+	}
+	int u = admissibles[i];
+	Block& k = block( u );
+	int v = k.mate[u%W];
+	COUNT( counters.admissibles++ );
+	COUNT( counters.labelled++ );
+	k.label |= 1U << ( u%W );
+	label_V[v] = true;
+	parent[v] = k.nhbor[u%W];
+	update_slack( v, s.row( v ) );
+      }
+    }
+
+  }
+
+  void hungarian_algorithm( HungarianSolver& s ) {
+
+    for ( int i = 0; i < N; i++ ) {
+      for ( Block& k: col ) {
+	fill( k.slack, k.slack+W, numeric_limits<ll>::max() );
+	fill( k.nhbor, k.nhbor+W, -1 );
+	k.label = 0U;
+      }
+      col.back().label = padding;
+      parent.assign( N, -1 );
+      label_V.assign( N, false );
+      COUNT( count_search( N-i ) );
+
+      // start with unmatched v in V
+      for ( int v = 0; v < N; v++ )
+	if ( mate_V[v] == -1 ) {
+	  label_V[v] = true;
+	  update_slack( v, s.row( v ) );
+	}
+
+      int u = search_augmenting_alternating_path( s );
+      if ( u == -1 ) {
+	s.cancelled = true;
+	return;
+      }
+
+      augment( block( u ).nhbor[u%W], u );
+      COUNT( count_augment() );
+
+      if ( s.progress ) {
+	ll sum = 0LL;
+	for ( int j = 0; j < N; j++ )
+	  sum += alpha[j]+block( j ).beta[j%W];
+	s.report_progress( i+1, sum );
+      }
+    }
+
+  }
+
+  // solve the instance of s and store the result in s
+  static void run( HungarianSolver& s ) {
+
+    static thread_local unique_ptr<HungarianPacked> workspace;
+    if ( not workspace ) workspace.reset( new HungarianPacked() );
+    HungarianPacked& w = *workspace;
+
+    Clock::time_point t0 = Clock::now();
+    perf_begin( perf.initialization );
+    int N = w.N = s.N;
+    w.full = N/W;
+    w.col.assign( ( N+W-1 )/W, Block() );
+    w.padding = N%W ? ~0U << ( N%W ) : 0U;
+    for ( int u = 0; u < int( w.col.size() )*W; u++ ) {
+      w.block( u ).beta[u%W] = u < N ? s.min_col[u] : 0LL;
+      w.block( u ).mate[u%W] = -1;
+    }
+    w.mate_V.assign( N, -1 );
+    w.alpha.assign( N, 0LL );
+    perf_end( perf.initialization );
+    s.timings.initialization = seconds_since( t0 );
+
+    t0 = Clock::now();
+    perf_begin( perf.search );
+    s.stopped = s.cancelled = false;
+    if ( N ) w.hungarian_algorithm( s );
+    perf_end( perf.search );
+    s.timings.search = seconds_since( t0 );
+
+    s.mate_V = w.mate_V;
+    s.alpha = w.alpha;
+    s.mate_U.resize( N );
+    s.beta.resize( N );
+    for ( int u = 0; u < N; u++ ) {
+      s.mate_U[u] = w.block( u ).mate[u%W];
+      s.beta[u] = w.block( u ).beta[u%W];
+    }
+
+  }
+
+};
+
+////////////////////////////////////////////////////////////////////////
+//
+// Engine selection for "--engine=auto". FEATURE_ROWS evenly spaced
+// rows are sampled for the value range, the spread of the row minima
+// (as a fraction of that range) and the diversity of the row argmins
+// (distinct argmin columns per sampled row, ties broken by a hash).
+// The first rule of the tuning table whose conditions all hold picks
+// the engine. Low diversity means that the rows share their cheap
+// columns (machol-wien, long-path), where the pruned engine keeps
+// expanding; elsewhere it is several times faster from N ~ 100.
+// "--tune=FILE" replaces the table, one rule per line:
+//
+//   <engine> [<feature><op><value> ...]     e.g. "pruned n>=100"
+//
+// with features n, min, max, range, spread and diversity, ops <, <=,
+// >, >= and ==, and "#" comments. bench.sh writes one from its sweep.
+//
+////////////////////////////////////////////////////////////////////////
+
+const int FEATURE_ROWS = 64;
+
+struct TuneCondition {
+  string feature, op;
+  double value;
+};
+
+struct TuneRule {
+  string engine, text;
+  vector<TuneCondition> when;
+};
+
+// empty on success, else the error
+string parse_tune( istream& in, vector<TuneRule>& rules ) {
+
+  rules.clear();
+  string line;
+  while ( getline( in, line ) ) {
+    line = line.substr( 0, line.find( '#' ) );
+    istringstream words( line );
+    TuneRule r;
+    if ( not ( words >> r.engine ) ) continue;
+    r.text = r.engine;
+    if ( r.engine != "fixed" and r.engine != "dense" and r.engine != "packed" and r.engine != "pruned" )
+      return "unknown engine " + r.engine;
+    string word;
+    while ( words >> word ) {
+      size_t op = word.find_first_of( "<>=" );
+      size_t value = word.find_first_not_of( "<>=", op );
+      TuneCondition c;
+      c.feature = word.substr( 0, op );
+      c.op = op == string::npos ? "" : word.substr( op, value-op );
+      if ( c.feature != "n" and c.feature != "min" and c.feature != "max" and c.feature != "range" and
+	   c.feature != "spread" and c.feature != "diversity" )
+	return "unknown feature in " + word;
+      if ( c.op != "<" and c.op != "<=" and c.op != ">" and c.op != ">=" and c.op != "==" )
+	return "bad condition " + word;
+      char* end;
+      c.value = value == string::npos ? 0.0 : strtod( word.c_str()+value, &end );
+      if ( value == string::npos or *end ) return "bad value in " + word;
+      r.when.push_back( c );
+      r.text += " " + word;
+    }
+    rules.push_back( r );
+  }
+  return "";
+
+}
+
+vector<TuneRule> default_tune() {
+
+  string packed = PACKED_AUTO ? "packed" : "dense";
+  istringstream in( "fixed n<=64\n" + packed + " diversity<0.25\npruned n>=100\n" + packed + "\n" );
+  vector<TuneRule> rules;
+  parse_tune( in, rules );
+  return rules;
+
+}
+
+vector<TuneRule> tune_rules = default_tune();
+
+string load_tune( const string& path ) {
+
+  ifstream in( path );
+  if ( not in ) return "cannot open " + path;
+  vector<TuneRule> rules;
+  string error = parse_tune( in, rules );
+  if ( not error.empty() ) return path + ": " + error;
+  tune_rules = rules;
+  return "";
+
+}
+
+void sample_features( const HungarianSolver& s, EngineChoice& f ) {
+
+  int N = s.N;
+  f.sampled = min( N, FEATURE_ROWS );
+  f.min_cost = numeric_limits<ll>::max();
+  f.max_cost = numeric_limits<ll>::min();
+  ll lo = numeric_limits<ll>::max(), hi = numeric_limits<ll>::min();
+  vector<ll> buf;
+  vector<int> argmin;
+  for ( int i = 0; i < f.sampled; i++ ) {
+    int v = int( ll( i )*N/f.sampled );
+    const ll* cv = s.row( v, buf );
+    int best = 0;
+    uint64_t best_hash = HungarianSolver::hash_step( uint64_t( v ), 0LL );
+    for ( int u = 0; u < N; u++ ) {
+      f.min_cost = min( f.min_cost, cv[u] );
+      f.max_cost = max( f.max_cost, cv[u] );
+      if ( cv[u] > cv[best] ) continue;
+      uint64_t h = HungarianSolver::hash_step( uint64_t( v ), ll( u ) );
+      if ( cv[u] < cv[best] or h < best_hash ) {
+	best = u;
+	best_hash = h;
+      }
+    }
+    lo = min( lo, cv[best] );
+    hi = max( hi, cv[best] );
+    argmin.push_back( best );
+  }
+  sort( argmin.begin(), argmin.end() );
+  f.diversity = double( unique( argmin.begin(), argmin.end() )-argmin.begin() )/max( 1, f.sampled );
+  f.min_cost /= 2;     // rows are doubled
+  f.max_cost /= 2;
+  f.spread = N ? double( hi-lo )/2.0/double( f.max_cost-f.min_cost+1 ) : 0.0;
+
+}
+
+double feature( const EngineChoice& f, const string& name ) {
+  if ( name == "n" ) return f.n;
+  if ( name == "min" ) return double( f.min_cost );
+  if ( name == "max" ) return double( f.max_cost );
+  if ( name == "range" ) return double( f.max_cost )-double( f.min_cost );
+  if ( name == "spread" ) return f.spread;
+  return f.diversity;
+}
+
+bool holds( const TuneCondition& c, double x ) {
+  if ( c.op == "<" ) return x < c.value;
+  if ( c.op == "<=" ) return x <= c.value;
+  if ( c.op == ">" ) return x > c.value;
+  if ( c.op == ">=" ) return x >= c.value;
+  return x == c.value;
+}
+
+// "--stats" reports the features even when no rule needed them
+bool report_features = false;
+
+// the engine for "auto"; the features and the rule go to s.choice
+string choose_engine( HungarianSolver& s ) {
+
+  EngineChoice& f = s.choice;
+  f = EngineChoice();
+  f.made = true;
+  f.n = s.N;
+  if ( s.has_deadline ) {
+    f.rule = "deadline (only dense can stop)";
+    return f.engine = "dense";
+  }
+
+  // rows are only sampled once a rule asks for more than n
+  bool sampled = false;
+  for ( const TuneRule& r: tune_rules ) {
+    if ( r.engine == "fixed" and ( s.N < 1 or s.N > FIXED_MAX_N ) ) continue;
+    bool match = true;
+    for ( const TuneCondition& c: r.when ) {
+      if ( not match ) break;
+      if ( c.feature != "n" and not sampled ) {
+	sample_features( s, f );
+	sampled = true;
+      }
+      match = holds( c, feature( f, c.feature ) );
+    }
+    if ( match ) {
+      if ( report_features and not sampled ) sample_features( s, f );
+      f.rule = r.text;
+      return f.engine = r.engine;
+    }
+  }
+  if ( report_features and not sampled ) sample_features( s, f );
+  f.rule = "none";
+  return f.engine = "dense";
+
+}
+
+// whether engine exists and can solve an instance of size N
+bool engine_solves( const string& engine, int N ) {
+  if ( engine == "fixed" ) return N >= 1 and N <= FIXED_MAX_N;
+  return engine == "auto" or engine == "dense" or engine == "packed" or engine == "pruned";
+}
+
+// runs the engine ("auto" picks one, see choose_engine) and returns
+// the engine used, or an empty string if it cannot solve the instance
+string solve( HungarianSolver& s, string engine ) {
+
+  if ( not engine_solves( engine, s.N ) ) return "";
+  if ( engine == "auto" ) engine = choose_engine( s );
+  else s.choice.made = false;
+
+  if ( engine == "fixed" )
+    fixed_algorithm( s );
+  else if ( engine == "dense" )
+    s.hungarian_algorithm();
+  else if ( engine == "packed" )
+    HungarianPacked<PACKED_WIDTH>::run( s );
+  else
+    s.pruned_algorithm( s.prune_k );
+
+  return engine;
+
+}
+
+////////////////////////////////////////////////////////////////////////
+//
+// Result cache: LRU of solved instances keyed by the hash of their
+// rows (computed while parsing). A hit is only returned after its
+// certificate checks out against the new matrix, so a hash collision
+// costs an O(N^2) pass, never a wrong answer. An instance of the same
+// N that differs in at most N/CACHE_NEAR_FRACTION rows is a near hit
+// and is solved from the cached duals (see warm_start). Entries are
+// immutable and shared, so the lock only covers the LRU list and the
+// counters: certificates, near-hit scans and warm starts run outside.
+//
+////////////////////////////////////////////////////////////////////////
+
+const int CACHE_NEAR_FRACTION = 8;
+
+struct CacheEntry {
+  uint64_t hash;
+  vector<uint64_t> row_hash;
+  vector<int> mate_V;
+  vector<ll> alpha, beta;
+
+  size_t bytes() const { return sizeof( CacheEntry )+row_hash.size()*28; }
+};
+
+typedef shared_ptr<const CacheEntry> CacheRef;
+
+struct ResultCache {
+
+  mutex m;
+  size_t capacity, bytes = 0;
+  list<CacheRef> lru;       // most recently used first
+  unordered_map<uint64_t,list<CacheRef>::iterator> index;
+  ll hits = 0, near_hits = 0, misses = 0, evictions = 0;
+
+  ResultCache( size_t capacity ) : capacity( capacity ) {}
+
+  static uint64_t matrix_hash( const HungarianSolver& s ) {
+    uint64_t h = uint64_t( s.N );
+    for ( uint64_t r: s.row_hash ) h = HungarianSolver::hash_step( h, ll( r ) );
+    return h;
+  }
+
+  // "hit" (s holds the result), "near" (s is warm started) or "miss"
+  string lookup( HungarianSolver& s ) {
+
+    uint64_t h = matrix_hash( s );
+    CacheRef exact;
+    vector<CacheRef> same_n;
+    {
+      lock_guard<mutex> lock( m );
+      auto it = index.find( h );
+      if ( it != index.end() ) exact = *it->second;
+      if ( s.N/CACHE_NEAR_FRACTION > 0 )
+	for ( const CacheRef& e: lru )
+	  if ( int( e->row_hash.size() ) == s.N ) same_n.push_back( e );
+    }
+
+    if ( exact and exact->row_hash == s.row_hash ) {
+      s.mate_V = exact->mate_V;
+      s.alpha = exact->alpha;
+      s.beta = exact->beta;
+      bool valid = s.verify_certificate().empty();
+      lock_guard<mutex> lock( m );
+      auto it = index.find( h );
+      bool present = it != index.end() and *it->second == exact;
+      if ( valid ) {
+	if ( present ) lru.splice( lru.begin(), lru, it->second );
+	hits++;
+	return "hit";
+      }
+      if ( present ) erase( it->second );
+    }
+
+    int limit = s.N/CACHE_NEAR_FRACTION;
+    vector<bool> changed( s.N );
+    for ( const CacheRef& e: same_n ) {
+      int differ = 0;
+      for ( int v = 0; v < s.N and differ <= limit; v++ )
+	if ( e->row_hash[v] != s.row_hash[v] ) differ++;
+      if ( differ > limit ) continue;
+
+      for ( int v = 0; v < s.N; v++ )
+	changed[v] = e->row_hash[v] != s.row_hash[v];
+      s.warm_start( e->mate_V, e->alpha, e->beta, changed );
+      lock_guard<mutex> lock( m );
+      auto it = index.find( e->hash );
+      if ( it != index.end() and *it->second == e ) lru.splice( lru.begin(), lru, it->second );
+      near_hits++;
+      return "near";
+    }
+
+    lock_guard<mutex> lock( m );
+    misses++;
+    return "miss";
+
+  }
+
+  void store( const HungarianSolver& s ) {
+
+    shared_ptr<CacheEntry> e = make_shared<CacheEntry>();
+    e->hash = matrix_hash( s );
+    e->row_hash = s.row_hash;
+    e->mate_V = s.mate_V;
+    e->alpha = s.alpha;
+    e->beta = s.beta;
+    if ( e->bytes() > capacity ) return;
+
+    lock_guard<mutex> lock( m );
+    auto it = index.find( e->hash );
+    if ( it != index.end() ) erase( it->second );
+    while ( bytes+e->bytes() > capacity ) {
+      erase( prev( lru.end() ) );
+      evictions++;
+    }
+    bytes += e->bytes();
+    lru.push_front( e );
+    index[e->hash] = lru.begin();
+
+  }
+
+  void erase( list<CacheRef>::iterator e ) {
+    bytes -= (*e)->bytes();
+    index.erase( (*e)->hash );
+    lru.erase( e );
+  }
+
+};
+
+// solve through the cache (if any); returns the engine used, "cache"
+// for a hit or "warm" for a near hit, or an empty string as solve()
+string solve_cached( HungarianSolver& s, const string& engine, ResultCache* cache ) {
+
+  // the answer must not depend on what the cache holds
+  if ( not engine_solves( engine, s.N ) ) return "";
+  if ( cache == nullptr ) return solve( s, engine );
+
+  string found = cache->lookup( s );
+  if ( found == "hit" ) return "cache";
+
+  string used = "warm";
+  if ( found == "near" ) s.hungarian_algorithm( true );
+  else used = solve( s, engine );
+
+  if ( not used.empty() and not s.stopped and not s.cancelled ) cache->store( s );
+  return used;
+
+}
+
+////////////////////////////////////////////////////////////////////////
+//
+// Forbidden entries ("--forbidden=X"): costs >= X are not edges, so
+// the assignment must avoid them. The allowed edges usually split the
+// rows and columns into connected components (found by union-find),
+// each of which is an independent instance: it must have as many rows
+// as columns, else no assignment avoids the forbidden entries, and
+// the blocks are solved separately on "--threads=T" workers, largest
+// first, then their matchings and duals are stitched together. The
+// certificate only checks the duals on allowed edges (see
+// verify_rows), since no constraint links two blocks.
+//
+// An instance that stays in one piece is solved whole, with every
+// forbidden entry raised to one cost that no assignment avoiding them
+// can reach (see forbid); its optimum uses one only if it must.
+//
+////////////////////////////////////////////////////////////////////////
+
+// raises the entries >= x of the in-memory matrix as above; returns an
+// empty string on success, else the reason
+string forbid( HungarianSolver& s, ll x ) {
+
+  if ( s.file or s.points ) return "--forbidden needs the matrix on the standard input";
+
+  int N = s.N;
+  ll limit = x > numeric_limits<ll>::max()/2 ? numeric_limits<ll>::max() :
+    x < numeric_limits<ll>::min()/2 ? numeric_limits<ll>::min() : 2LL*x;
+  ll lo = numeric_limits<ll>::max(), hi = numeric_limits<ll>::min();
+  for ( int v = 0; v < N; v++ ) {
+    const ll* cv = s.c[v];
+    for ( int u = 0; u < N; u++ )
+      if ( cv[u] < limit ) {
+	lo = min( lo, cv[u] );
+	hi = max( hi, cv[u] );
+      }
+  }
+  if ( lo > hi ) lo = hi = 0LL;
+
+  // using a forbidden entry costs more than (N-1)*(hi-lo), the most
+  // that any assignment of allowed entries can lose to another
+  long double big = (long double)( hi )+(long double)( N )*( (long double)( hi )-lo )+2.0L;
+  if ( big*( N+1 ) > (long double)( numeric_limits<ll>::max()/2 ) )
+    return "costs are too far apart for --forbidden";
+  s.forbidden = ll( big );
+  if ( s.forbidden % 2LL ) s.forbidden++;
+
+  for ( int u = 0; u < N; u++ ) s.min_col[u] = numeric_limits<ll>::max();
+  for ( int v = 0; v < N; v++ ) {
+    ll* cv = s.c[v];
+    for ( int u = 0; u < N; u++ ) {
+      if ( cv[u] >= limit ) cv[u] = s.forbidden;
+      s.min_col[u] = min( s.min_col[u], cv[u] );
+    }
+  }
+  return "";
+
+}
+
+// numbers the connected components of the allowed edges from 0 into
+// block[v] for row v and block[N+u] for column u; returns their count
+int components( const HungarianSolver& s, vector<int>& block ) {
+
+  int N = s.N;
+  vector<int> parent( 2*N );
+  for ( int i = 0; i < 2*N; i++ ) parent[i] = i;
+  auto find = [&]( int i ) {
+    while ( parent[i] != i ) i = parent[i] = parent[parent[i]];
+    return i;
+  };
+
+  for ( int v = 0; v < N; v++ ) {
+    const ll* cv = s.c[v];
+    for ( int u = 0; u < N; u++ )
+      if ( cv[u] < s.forbidden ) {
+	int a = find( v ), b = find( N+u );
+	if ( a != b ) parent[b] = a;
+      }
+  }
+
+  int count = 0;
+  block.assign( 2*N, -1 );
+  for ( int i = 0; i < 2*N; i++ ) {
+    int r = find( i );
+    if ( block[r] < 0 ) block[r] = count++;
+    block[i] = block[r];
+  }
+  return count;
+
+}
+
+// an empty string unless the assignment uses a forbidden entry
+string forbidden_error( const HungarianSolver& s ) {
+
+  for ( int v = 0; v < s.N; v++ )
+    if ( s.c[v][s.mate_V[v]] >= s.forbidden )
+      return s.stopped ? "no assignment avoiding the forbidden entries was found by the deadline" :
+	"no assignment avoids the forbidden entries";
+  return "";
+
+}
+
+// solves an instance with forbidden entries (see forbid) block by
+// block; returns the engine used ("blocks" if it was split), or an
+// empty string as solve(), and sets error if there is no assignment
+string solve_blocks( HungarianSolver& s, const string& engine, int threads,
+		     ResultCache* cache, string& error ) {
+
+  Clock::time_point t0 = Clock::now();
+  int N = s.N;
+  vector<int> block;
+  int count = components( s, block );
+  s.decomposition = Decomposition();
+  s.decomposition.blocks = count;
+
+  if ( count <= 1 ) {
+    string used = solve_cached( s, engine, cache );
+    s.decomposition.largest = N;
+    if ( not used.empty() and not s.cancelled ) error = forbidden_error( s );
+    return used;
+  }
+
+  vector<vector<int>> rows( count ), cols( count );
+  for ( int v = 0; v < N; v++ ) rows[block[v]].push_back( v );
+  for ( int u = 0; u < N; u++ ) cols[block[N+u]].push_back( u );
+  for ( int k = 0; k < count; k++ )
+    if ( rows[k].size() != cols[k].size() ) {
+      error = "no assignment avoids the forbidden entries ("+to_string( rows[k].size() )+
+	" rows but "+to_string( cols[k].size() )+" columns in the component of "+
+	( rows[k].empty() ? "column "+to_string( cols[k][0] ) : "row "+to_string( rows[k][0] ) )+")";
+      return "";
+    }
+
+  vector<int> order( count );
+  for ( int k = 0; k < count; k++ ) order[k] = k;
+  sort( order.begin(), order.end(), [&]( int a, int b ) { return rows[a].size() > rows[b].size(); } );
+
+  s.mate_V.assign( N, -1 );
+  s.mate_U.assign( N, -1 );
+  s.alpha.assign( N, 0LL );
+  s.beta.assign( N, 0LL );
+  s.stopped = s.cancelled = false;
+  s.matched_at_stop = 0;
+  s.choice.made = false;
+  s.timings.initialization = seconds_since( t0 );
+
+  // each worker keeps one solver, so that its memory stays warm; with
+  // a deadline every block stops at it (and is completed greedily)
+  t0 = Clock::now();
+  threads = max( 1, min( threads, count ) );
+  vector<string> used( count );
+  atomic<int> next{ 0 }, matched{ 0 };
+  atomic<bool> stopped{ false };
+  COUNT( vector<Counters> worker_counters( threads ) );
+  HungarianSolver::parallel( threads, [&]( int t ) {
+    HungarianSolver b;
+    b.prune_k = s.prune_k;
+    b.has_deadline = s.has_deadline;
+    b.deadline = s.deadline;
+    vector<ll> costs;
+    for ( int i; ( i = next++ ) < count; ) {
+      int k = order[i], n = int( rows[k].size() );
+      const vector<int>& r = rows[k];
+      const vector<int>& q = cols[k];
+      costs.resize( size_t( n )*n );
+      for ( int a = 0; a < n; a++ ) {
+	const ll* cv = s.c[r[a]];
+	for ( int j = 0; j < n; j++ ) costs[size_t( a )*n+j] = cv[q[j]]/2LL;
+      }
+      b.load( n, costs.data() );
+      b.stopped = false;
+      used[k] = solve( b, engine );
+      if ( used[k].empty() ) continue;
+      if ( b.stopped ) stopped = true;
+      matched += b.stopped ? b.matched_at_stop : n;
+      for ( int a = 0; a < n; a++ ) {
+	s.mate_V[r[a]] = q[b.mate_V[a]];
+	s.mate_U[q[b.mate_V[a]]] = r[a];
+	s.alpha[r[a]] = b.alpha[a];
+      }
+      for ( int j = 0; j < n; j++ ) s.beta[q[j]] = b.beta[j];
+    }
+    // worker 0 is this thread, whose counters stay where they are
+    COUNT( if ( t > 0 ) worker_counters[t] = counters );
+  } );
+  COUNT( for ( int t = 1; t < threads; t++ ) count_merge( merged, worker_counters[t] ) );
+  s.timings.search = seconds_since( t0 );
+
+  for ( int k = 0; k < count; k++ )
+    if ( used[k].empty() ) return "";
+  if ( stopped ) {
+    s.stopped = true;
+    s.matched_at_stop = matched;
+  }
+  error = forbidden_error( s );
+  s.decomposition.largest = int( rows[order[0]].size() );
+  s.decomposition.threads = threads;
+  s.decomposition.engine = used[order[0]];
+  return "blocks";
+
+}
+
+////////////////////////////////////////////////////////////////////////
+//
+// Solve pool: worker threads that run solves in time slices of
+// "slice" seconds. A solve that is not finished after its slice goes
+// back to the tail of the queue, so a long solve shares the workers
+// with the short ones queued behind it instead of holding one until it
+// is done; slice 0 runs every solve to completion. Only the dense
+// engine can pause between two augmentations (continue_search), so
+// with slices "auto" picks it above FIXED_MAX_N and the other engines
+// run whole.
+//
+// A started solve keeps its workspace (an N x N matrix) until it is
+// done, so at most SOLVE_POOL_STARTED per worker are started at once;
+// the requests behind them stay queued, unloaded, in arrival order.
+//
+////////////////////////////////////////////////////////////////////////
+
+const int SOLVE_POOL_STARTED = 2;
+
+struct SolveTask {
+  string engine;
+  function<void(HungarianSolver&)> load;   // fills the solver, on the worker
+  // on the worker: the solver and the engine used ("" if the engine
+  // cannot solve it, see solve), or nullptr if the pool cancelled it
+  function<void(HungarianSolver*,const string&)> done;
+
+  unique_ptr<HungarianSolver> s;           // set once started
+  string used;
+  bool sliced = false;                     // runs in slices (not solve_cached)
+  bool admitted = false;                   // counted in SolvePool::started
+  ll ticket = 0;                           // queue order
+};
+
+struct SolvePool {
+
+  mutex m;
+  condition_variable cv;
+  deque<SolveTask*> fresh, resumed;           // not started, started
+  ll tickets = 0;
+  int started = 0, max_started;               // admitted and not finished
+  vector<unique_ptr<HungarianSolver>> idle;   // warm workspaces
+  vector<thread> workers;
+  bool closed = false;
+  atomic<bool> cancel{ false };
+  double slice;
+  ResultCache* cache;
+
+  SolvePool( int threads, double slice, ResultCache* cache ) :
+    max_started( SOLVE_POOL_STARTED*threads ), slice( slice ), cache( cache ) {
+    for ( int t = 0; t < threads; t++ )
+      workers.emplace_back( &SolvePool::work, this );
+  }
+
+  ~SolvePool() { shutdown(); }
+
+  void submit( SolveTask* t ) {
+    {
+      lock_guard<mutex> lock( m );
+      t->ticket = tickets++;
+      ( t->s ? resumed : fresh ).push_back( t );
+    }
+    cv.notify_one();
+  }
+
+  // under m: whether pick has a task
+  bool runnable() const {
+    return not resumed.empty() or ( not fresh.empty() and started < max_started );
+  }
+
+  // under m: the oldest task that may run now
+  SolveTask* pick() {
+    SolveTask* t;
+    if ( not fresh.empty() and started < max_started and
+	 ( resumed.empty() or fresh.front()->ticket < resumed.front()->ticket ) ) {
+      t = fresh.front();
+      fresh.pop_front();
+      t->admitted = true;
+      started++;
+    } else {
+      t = resumed.front();
+      resumed.pop_front();
+    }
+    return t;
+  }
+
+  // cancels the solves in flight and the queued ones, then joins
+  void shutdown() {
+    cancel = true;
+    { lock_guard<mutex> lock( m ); closed = true; }
+    cv.notify_all();
+    for ( thread& th: workers ) th.join();
+    workers.clear();
+    for ( deque<SolveTask*>* q: { &fresh, &resumed } ) {
+      for ( SolveTask* t: *q ) {
+	t->done( nullptr, "" );
+	delete t;
+      }
+      q->clear();
+    }
+  }
+
+  void work() {
+
+    while ( true ) {
+      SolveTask* t;
+      {
+	unique_lock<mutex> lock( m );
+	cv.wait( lock, [this]() { return closed or runnable(); } );
+	if ( closed ) return;
+	t = pick();
+      }
+
+      if ( cancel ) {
+	finish( t );
+	continue;
+      }
+
+      bool finished;
+      if ( not t->s ) {
+	t->s = take();
+	t->load( *t->s );
+	finished = start( *t );
+      } else {
+	finished = t->s->continue_search( Clock::now()+slice_length() );
+      }
+
+      if ( finished ) finish( t );
+      else submit( t );
+    }
+
+  }
+
+  Clock::duration slice_length() const {
+    return chrono::duration_cast<Clock::duration>( chrono::duration<double>( slice ) );
+  }
+
+  // runs the first slice; true if the solve is done
+  bool start( SolveTask& t ) {
+
+    HungarianSolver& s = *t.s;
+    string engine = t.engine;
+    if ( not engine_solves( engine, s.N ) ) {
+      t.used = "";
+      return true;
+    }
+    if ( engine == "auto" and s.N > FIXED_MAX_N and slice > 0.0 ) {
+      s.choice = EngineChoice();
+      s.choice.made = true;
+      s.choice.n = s.N;
+      s.choice.rule = "slice (only dense can pause)";
+      engine = s.choice.engine = "dense";
+    }
+    if ( engine != "dense" or slice <= 0.0 ) {
+      t.used = solve_cached( s, engine, cache );
+      return true;
+    }
+
+    string found = cache ? cache->lookup( s ) : "miss";
+    if ( found == "hit" ) {
+      t.used = "cache";
+      return true;
+    }
+    t.used = found == "near" ? "warm" : "dense";
+    t.sliced = true;
+    s.begin_search( found == "near" );
+    return s.continue_search( Clock::now()+slice_length() );
+
+  }
+
+  void finish( SolveTask* t ) {
+
+    HungarianSolver* s = t->s.get();
+    if ( s and s->cancelled ) s = nullptr;
+    if ( s and t->sliced and cache and not s->stopped ) cache->store( *s );
+    t->done( s, s ? t->used : "" );
+
+    bool admitted = t->admitted;
+    {
+      lock_guard<mutex> lock( m );
+      if ( t->s and idle.size() < workers.size() ) idle.push_back( move( t->s ) );
+      if ( admitted ) started--;
+    }
+    delete t;
+    if ( admitted ) cv.notify_one();
+
+  }
+
+  unique_ptr<HungarianSolver> take() {
+    lock_guard<mutex> lock( m );
+    unique_ptr<HungarianSolver> s;
+    if ( idle.empty() ) {
+      s.reset( new HungarianSolver() );
+      s->cancel = &cancel;
+    } else {
+      s = move( idle.back() );
+      idle.pop_back();
+    }
+    return s;
+  }
+
+};
+
+////////////////////////////////////////////////////////////////////////
+//
+// Output: everything is rendered into one buffer (two digits at a
+// time) and handed to a single write(2), instead of a flush per line
+//
+////////////////////////////////////////////////////////////////////////
+
+const char digit_pairs[] =
+  "00010203040506070809101112131415161718192021222324252627282930313233343536373839"
+  "40414243444546474849505152535455565758596061626364656667686970717273747576777879"
+  "8081828384858687888990919293949596979899";
+
+struct OutputBuffer {
+
+  string buf;
+
+  void put( char ch ) { buf += ch; }
+  void put( const char* s ) { buf += s; }
+
+  void put_int( ll x ) {
+    char tmp[24], *p = tmp+24;
+    unsigned long long y = x < 0LL ? 0ULL-(unsigned long long)( x ) : x;
+    while ( y >= 100ULL ) {
+      int d = int( y%100ULL )*2;
+      y /= 100ULL;
+      *--p = digit_pairs[d+1];
+      *--p = digit_pairs[d];
+    }
+    if ( y >= 10ULL ) {
+      *--p = digit_pairs[2*y+1];
+      *--p = digit_pairs[2*y];
+    } else *--p = char( '0'+y );
+    if ( x < 0LL ) *--p = '-';
+    buf.append( p, tmp+24-p );
+  }
+
+  // x is in doubled units (see read_input): write x/2 exactly
+  void put_half( ll x ) {
+    if ( x < 0LL and x/2LL == 0LL ) put( '-' );
+    put_int( x/2LL );
+    if ( x%2LL != 0LL ) put( ".5" );
+  }
+
+  void put_raw( const void* data, size_t size ) {
+    buf.append( (const char*)( data ), size );
+  }
+
+  bool flush( int fd ) {
+    size_t done = 0;
+    while ( done < buf.size() ) {
+      ssize_t w = write( fd, buf.data()+done, buf.size()-done );
+      if ( w < 0 and errno == EINTR ) continue;
+      if ( w <= 0 ) return false;
+      done += size_t( w );
+    }
+    buf.clear();
+    return true;
+  }
+
+};
+
+void write_output( OutputBuffer& out, const HungarianSolver& s, const string& format ) {
+
+  int N = s.N;
+
+  if ( format == "match" ) {        // assignment itself
+    out.buf.reserve( size_t( N )*8 );
+    for ( int v = 0; v < N; v++ ) {
+      out.put_int( s.mate_V[v] );
+      out.put( '\n' );
+    }
+  } else if ( format == "binary" ) { // assignment as raw int32
+    vector<int32_t> perm( s.mate_V.begin(), s.mate_V.end() );
+    out.put_raw( perm.data(), perm.size()*sizeof( int32_t ) );
+  } else if ( format == "json" ) {   // cost, assignment and duals
+    out.buf.reserve( size_t( N )*32 );
+    out.put( "{\"cost\":" );
+    out.put_int( s.assignment_cost() );
+    if ( s.stopped ) {
+      out.put( ",\"optimal\":false,\"lower_bound\":" );
+      out.put_int( s.lower_bound() );
+    }
+    out.put( ",\"matching\":[" );
+    for ( int v = 0; v < N; v++ ) {
+      if ( v ) out.put( ',' );
+      out.put_int( s.mate_V[v] );
+    }
+    out.put( "],\"alpha\":[" );
+    for ( int v = 0; v < N; v++ ) {
+      if ( v ) out.put( ',' );
+      out.put_half( s.alpha[v] );
+    }
+    out.put( "],\"beta\":[" );
+    for ( int u = 0; u < N; u++ ) {
+      if ( u ) out.put( ',' );
+      out.put_half( s.beta[u] );
+    }
+    out.put( "]}\n" );
+  } else {                          // optimal assignment cost
+    out.put_int( s.assignment_cost() );
+    out.put( '\n' );
+  }
+
+}
+
+////////////////////////////////////////////////////////////////////////
+//
+// Capacitated (many-to-one) assignment, "--capacitated": n jobs (rows)
+// go to m machines (columns), machine u taking at most cap[u] of them.
+// Instead of replicating column u cap[u] times, the search treats a
+// column as free while it has room left, keeps one dual per machine
+// and the list of rows matched to it, and labels all of those rows at
+// once when a full column becomes admissible. Each of the n searches
+// is O(n*m + m^2) whatever the capacities. beta stays 0 on the columns
+// that are not full (their capacity constraint is slack) and only goes
+// negative on full ones, so the optimum is sum(alpha)+sum(cap*beta).
+//
+// Input: "n m", the n x m costs row by row, then the m capacities,
+// which must add up to n at least.
+//
+////////////////////////////////////////////////////////////////////////
+
+struct CapacitatedSolver {
+
+  int n = 0, m = 0;
+  vector<ll> cost;              // n x m, not doubled
+  vector<int> cap;
+  vector<int> mate;             // machine of each job
+  vector<vector<int>> assigned; // jobs of each machine
+  vector<int> slot;             // index of job v in assigned[mate[v]]
+  vector<ll> alpha, beta;
+  ll total_capacity = 0LL;
+  Timings timings;
+
+  const ll* row( int v ) const { return cost.data()+size_t( v )*m; }
+
+  bool full( int u ) const { return int( assigned[u].size() ) >= cap[u]; }
+
+  // returns an empty string on success, else the reason
+  string read_input() {
+
+    if ( not ( cin >> n >> m ) or n < 0 or m < 0 ) return "bad n m";
+    cost.resize( size_t( n )*m );
+    for ( ll& x: cost ) cin >> x;
+    cap.resize( m );
+    for ( int& k: cap ) cin >> k;
+    if ( not cin ) return "expected "+to_string( ll( n )*m )+" costs and "+to_string( m )+" capacities";
+
+    total_capacity = 0LL;
+    for ( int u = 0; u < m; u++ ) {
+      if ( cap[u] < 0 ) return "negative capacity of column "+to_string( u );
+      total_capacity += cap[u];
+    }
+    if ( total_capacity < n ) return "the capacities add up to fewer than n";
+    return "";
+
+  }
+
+  void match( int v, int u ) {
+    mate[v] = u;
+    slot[v] = int( assigned[u].size() );
+    assigned[u].push_back( v );
+  }
+
+  void unmatch( int v ) {
+    vector<int>& a = assigned[mate[v]];
+    a[slot[v]] = a.back();
+    slot[a.back()] = slot[v];
+    a.pop_back();
+    mate[v] = -1;
+  }
+
+  void solve() {
+
+    Clock::time_point t0 = Clock::now();
+    mate.assign( n, -1 );
+    slot.assign( n, 0 );
+    assigned.assign( m, vector<int>() );
+    alpha.assign( n, 0LL );
+    beta.assign( m, 0LL );
+
+    // row reduction; rows whose cheapest column has room take it
+    for ( int v = 0; v < n; v++ ) {
+      const ll* cv = row( v );
+      int best = 0;
+      for ( int u = 1; u < m; u++ )
+	if ( cv[u] < cv[best] ) best = u;
+      alpha[v] = cv[best];
+      if ( not full( best ) ) match( v, best );
+    }
+    timings.initialization = seconds_since( t0 );
+
+    t0 = Clock::now();
+    vector<ll> slack( m );
+    vector<int> from( m );      // labelled row that gives slack[u]
+    vector<char> labelled( m );
+    vector<int> rows, cols;
+    for ( int r = 0; r < n; r++ ) {
+      if ( mate[r] >= 0 ) continue;
+
+      fill( slack.begin(), slack.end(), numeric_limits<ll>::max() );
+      fill( labelled.begin(), labelled.end(), 0 );
+      rows.assign( 1, r );
+      cols.clear();
+      size_t scanned = 0;
+      while ( true ) {
+	for ( ; scanned < rows.size(); scanned++ ) {
+	  int v = rows[scanned];
+	  const ll* cv = row( v );
+	  for ( int u = 0; u < m; u++ ) {
+	    if ( labelled[u] ) continue;
+	    ll reduced = cv[u]-alpha[v]-beta[u];
+	    if ( reduced < slack[u] ) {
+	      slack[u] = reduced;
+	      from[u] = v;
+	    }
+	  }
+	}
+
+	// labelled columns are full, so one with room is left
+	int best = -1;
+	for ( int u = 0; u < m; u++ ) {
+	  if ( labelled[u] ) continue;
+	  if ( best < 0 or slack[u] < slack[best] or
+	       ( slack[u] == slack[best] and full( best ) and not full( u ) ) )
+	    best = u;
+	}
+	ll theta = slack[best];
+	if ( theta > 0 ) {
+	  for ( int v: rows ) alpha[v] += theta;
+	  for ( int u: cols ) beta[u] -= theta;
+	  for ( int u = 0; u < m; u++ )
+	    if ( not labelled[u] ) slack[u] -= theta;
+	}
+
+	labelled[best] = 1;
+	if ( not full( best ) ) {
+	  augment( best, from );
+	  break;
+	}
+	cols.push_back( best );
+	rows.insert( rows.end(), assigned[best].begin(), assigned[best].end() );
+      }
+    }
+    timings.search = seconds_since( t0 );
+
+  }
+
+  // row from[u] moves to u, the column it leaves takes its own from,
+  // and so on back to the unmatched row of the search
+  void augment( int u, const vector<int>& from ) {
+    while ( true ) {
+      int v = from[u], next = mate[v];
+      if ( next >= 0 ) unmatch( v );
+      match( v, u );
+      if ( next < 0 ) break;
+      u = next;
+    }
+  }
+
+  ll assignment_cost() const {
+    ll sum = 0LL;
+    for ( int v = 0; v < n; v++ ) sum += row( v )[mate[v]];
+    return sum;
+  }
+
+  ll dual_bound() const {
+    ll sum = 0LL;
+    for ( int v = 0; v < n; v++ ) sum += alpha[v];
+    for ( int u = 0; u < m; u++ ) sum += ll( cap[u] )*beta[u];
+    return sum;
+  }
+
+  // empty if (mate, alpha, beta) certify an optimum, else the reason
+  string verify_certificate() const {
+
+    vector<int> load( m, 0 );
+    for ( int v = 0; v < n; v++ ) {
+      if ( mate[v] < 0 or mate[v] >= m ) return "row "+to_string( v )+" is not assigned";
+      if ( ++load[mate[v]] > cap[mate[v]] ) return "column "+to_string( mate[v] )+" is over capacity";
+    }
+    for ( int u = 0; u < m; u++ )
+      if ( beta[u] > 0 or ( beta[u] < 0 and load[u] < cap[u] ) )
+	return "dual of column "+to_string( u )+" violates its capacity constraint";
+    for ( int v = 0; v < n; v++ ) {
+      const ll* cv = row( v );
+      for ( int u = 0; u < m; u++ )
+	if ( alpha[v]+beta[u] > cv[u] )
+	  return "dual infeasible at ("+to_string( v )+","+to_string( u )+")";
+      if ( alpha[v]+beta[mate[v]] != cv[mate[v]] )
+	return "assigned edge of row "+to_string( v )+" is not tight";
+    }
+    return "";
+
+  }
+
+};
+
+void write_output( OutputBuffer& out, const CapacitatedSolver& s, const string& format ) {
+
+  if ( format == "match" ) {
+    for ( int v = 0; v < s.n; v++ ) {
+      out.put_int( s.mate[v] );
+      out.put( '\n' );
+    }
+  } else if ( format == "binary" ) {
+    vector<int32_t> mate( s.mate.begin(), s.mate.end() );
+    out.put_raw( mate.data(), mate.size()*sizeof( int32_t ) );
+  } else if ( format == "json" ) {
+    out.put( "{\"cost\":" );
+    out.put_int( s.assignment_cost() );
+    out.put( ",\"matching\":[" );
+    for ( int v = 0; v < s.n; v++ ) {
+      if ( v ) out.put( ',' );
+      out.put_int( s.mate[v] );
+    }
+    out.put( "],\"alpha\":[" );
+    for ( int v = 0; v < s.n; v++ ) {
+      if ( v ) out.put( ',' );
+      out.put_int( s.alpha[v] );
+    }
+    out.put( "],\"beta\":[" );
+    for ( int u = 0; u < s.m; u++ ) {
+      if ( u ) out.put( ',' );
+      out.put_int( s.beta[u] );
+    }
+    out.put( "]}\n" );
+  } else {
+    out.put_int( s.assignment_cost() );
+    out.put( '\n' );
+  }
+
+}
+
+////////////////////////////////////////////////////////////////////////
+//
+// Solver daemon: "--serve <socket>" (see protocol.h)
+//
+// One epoll thread owns every connection: it reads requests as they
+// arrive, hands complete ones to a pool of workers, each with its own
+// warm HungarianSolver, and writes the responses back when the workers
+// signal them through an eventfd.
+//
+////////////////////////////////////////////////////////////////////////
+
+#ifdef __linux__
+
+struct ServeJob {
+  ll conn;              // connection id (fds get reused, ids do not)
+  uint32_t id, flags;
+  int n;
+  vector<ll> costs;
+  OutputBuffer response;
+};
+
+struct ServeQueue {
+
+  mutex m;
+  condition_variable cv;
+  deque<ServeJob*> q;
+  bool closed = false;
+
+  void push( ServeJob* job ) {
+    { lock_guard<mutex> lock( m ); q.push_back( job ); }
+    cv.notify_one();
+  }
+
+  // nullptr once closed (or, without wait, when empty)
+  ServeJob* pop( bool wait ) {
+    unique_lock<mutex> lock( m );
+    if ( wait ) cv.wait( lock, [this]() { return closed or not q.empty(); } );
+    if ( q.empty() ) return nullptr;
+    ServeJob* job = q.front();
+    q.pop_front();
+    return job;
+  }
+
+  void close() {
+    { lock_guard<mutex> lock( m ); closed = true; }
+    cv.notify_all();
+  }
+
+};
+
+struct ServeConn {
+  int fd;
+  string in, out;
+  size_t out_done = 0;
+  int pending = 0;          // requests handed to the workers
+  bool eof = false;
+  uint32_t events = EPOLLIN | EPOLLRDHUP;
+};
+
+volatile sig_atomic_t serve_stop = 0;
+
+void serve_signal( int ) { serve_stop = 1; }
+
+template<typename T>
+void put_value( OutputBuffer& out, T x ) { out.put_raw( &x, sizeof( T ) ); }
+
+void serve_respond( ServeJob& job, int32_t status, const HungarianSolver* s ) {
+
+  int n = s ? s->N : 0;
+  bool duals = s and ( job.flags & SERVE_DUALS );
+  size_t size = SERVE_RESPONSE_HEADER-4+4*size_t( n )+( duals ? 16*size_t( n ) : 0 );
+
+  OutputBuffer& out = job.response;
+  out.buf.reserve( size+4 );
+  put_value<uint32_t>( out, uint32_t( size ) );
+  put_value<uint32_t>( out, job.id );
+  put_value<int32_t>( out, status );
+  put_value<int32_t>( out, n );
+  put_value<int64_t>( out, s ? s->optimal_cost() : 0LL );
+  for ( int v = 0; v < n; v++ )
+    put_value<int32_t>( out, s->mate_V[v] );
+  if ( duals ) {
+    out.put_raw( s->alpha.data(), 8*size_t( n ) );
+    out.put_raw( s->beta.data(), 8*size_t( n ) );
+  }
+
+}
+
+// split c.in into requests; false on a framing error (drop connection)
+bool serve_parse( ServeConn& c, ll conn, const function<void(ServeJob*)>& submit ) {
+
+  size_t pos = 0;
+  while ( c.in.size()-pos >= 4 ) {
+    uint32_t size;
+    memcpy( &size, c.in.data()+pos, 4 );
+    if ( size < SERVE_REQUEST_HEADER-4 or
+	 size > SERVE_REQUEST_HEADER-4+8*size_t( SERVE_MAX_N )*SERVE_MAX_N )
+      return false;
+    if ( c.in.size()-pos < 4+size_t( size ) ) break;
+
+    const char* p = c.in.data()+pos;
+    ServeJob* job = new ServeJob();
+    int32_t n;
+    job->conn = conn;
+    memcpy( &job->id, p+4, 4 );
+    memcpy( &job->flags, p+8, 4 );
+    memcpy( &n, p+12, 4 );
+    job->n = n;
+    c.pending++;
+    if ( n < 0 or n > SERVE_MAX_N or size != SERVE_REQUEST_HEADER-4+8*size_t( n )*n or
+	 ( job->flags & SERVE_ENGINE_MASK ) >= SERVE_ENGINES ) {
+      serve_respond( *job, SERVE_EBADREQUEST, nullptr );
+      job->n = -1;  // already answered
+    } else {
+      job->costs.resize( size_t( n )*n );
+      memcpy( job->costs.data(), p+SERVE_REQUEST_HEADER, 8*size_t( n )*n );
+    }
+    pos += 4+size_t( size );
+
+    if ( job->n < 0 ) {
+      c.out += job->response.buf;
+      c.pending--;
+      delete job;
+    } else submit( job );
+  }
+  c.in.erase( 0, pos );
+  return true;
+
+}
+
+// returns 0 on success, else the exit status
+int serve( const string& path, int threads, double slice, ResultCache* cache ) {
+
+  int listen_fd = socket( AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0 );
+  sockaddr_un addr;
+  memset( &addr, 0, sizeof( addr ) );
+  addr.sun_family = AF_UNIX;
+  if ( path.size() >= sizeof( addr.sun_path ) ) {
+    cerr << "hungarian: socket path too long" << endl;
+    return 1;
+  }
+  strcpy( addr.sun_path, path.c_str() );
+
+  // replace a stale socket left by a previous daemon
+  struct stat st;
+  if ( stat( path.c_str(), &st ) == 0 and S_ISSOCK( st.st_mode ) )
+    unlink( path.c_str() );
+
+  if ( listen_fd < 0 or bind( listen_fd, (sockaddr*)( &addr ), sizeof( addr ) ) < 0 or
+       listen( listen_fd, 128 ) < 0 ) {
+    cerr << "hungarian: cannot listen on " << path << ": " << strerror( errno ) << endl;
+    return 1;
+  }
+
+  struct sigaction sa;
+  memset( &sa, 0, sizeof( sa ) );
+  sa.sa_handler = serve_signal;
+  sigaction( SIGINT, &sa, nullptr );
+  sigaction( SIGTERM, &sa, nullptr );
+  signal( SIGPIPE, SIG_IGN );
+
+  const ll LISTEN = 0, WAKE = 1;
+  int ep = epoll_create1( EPOLL_CLOEXEC );
+  int wake_fd = eventfd( 0, EFD_NONBLOCK | EFD_CLOEXEC );
+  epoll_event ev;
+  ev.events = EPOLLIN;
+  ev.data.u64 = LISTEN;
+  epoll_ctl( ep, EPOLL_CTL_ADD, listen_fd, &ev );
+  ev.data.u64 = WAKE;
+  epoll_ctl( ep, EPOLL_CTL_ADD, wake_fd, &ev );
+
+  // answered jobs go back to the epoll thread through done
+  ServeQueue done;
+  SolvePool pool( threads, slice, cache );
+  auto submit = [&]( ServeJob* job ) {
+    SolveTask* t = new SolveTask();
+    t->engine = serve_engines[job->flags & SERVE_ENGINE_MASK];
+    t->load = [job]( HungarianSolver& s ) {
+      s.load( job->n, job->costs.data() );
+      job->costs = vector<ll>();
+    };
+    t->done = [job,&done,wake_fd]( HungarianSolver* s, const string& used ) {
+      if ( s and used.empty() ) serve_respond( *job, SERVE_EENGINE, nullptr );
+      else if ( s ) serve_respond( *job, SERVE_OK, s );
+      done.push( job );
+      uint64_t one = 1;
+      if ( write( wake_fd, &one, sizeof( one ) ) < 0 ) { /* counter saturated */ }
+    };
+    pool.submit( t );
+  };
+
+  unordered_map<ll,ServeConn> conns;
+  ll next_conn = 2;
+
+  // poll for input until EOF and for output while some is pending
+  auto watch = [&]( ll id, ServeConn& c ) {
+    uint32_t want = ( c.eof ? 0 : EPOLLIN | EPOLLRDHUP ) | ( c.out.empty() ? 0 : EPOLLOUT );
+    if ( want == c.events ) return;
+    c.events = want;
+    epoll_event e;
+    e.events = want;
+    e.data.u64 = id;
+    epoll_ctl( ep, EPOLL_CTL_MOD, c.fd, &e );
+  };
+
+  auto flush = [&]( ServeConn& c ) {
+    while ( c.out_done < c.out.size() ) {
+      ssize_t w = send( c.fd, c.out.data()+c.out_done, c.out.size()-c.out_done, MSG_NOSIGNAL );
+      if ( w < 0 and errno == EINTR ) continue;
+      if ( w < 0 and ( errno == EAGAIN or errno == EWOULDBLOCK ) ) break;
+      if ( w < 0 ) return false;
+      c.out_done += size_t( w );
+    }
+    if ( c.out_done == c.out.size() ) {
+      c.out.clear();
+      c.out_done = 0;
+    }
+    return true;
+  };
+
+  auto drop = [&]( ll id ) {
+    close( conns[id].fd );
+    conns.erase( id );
+  };
+
+  cerr << "hungarian: serving on " << path << " with " << threads << " workers";
+  if ( slice > 0.0 ) cerr << " and " << 1e3*slice << " ms slices";
+  cerr << endl;
+
+  vector<epoll_event> events( 64 );
+  while ( not serve_stop ) {
+    int k = epoll_wait( ep, events.data(), int( events.size() ), -1 );
+    if ( k < 0 ) {
+      if ( errno == EINTR ) continue;
+      break;
+    }
+
+    for ( int e = 0; e < k; e++ ) {
+      ll id = ll( events[e].data.u64 );
+
+      if ( id == LISTEN ) {
+	int fd;
+	while ( ( fd = accept4( listen_fd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC ) ) >= 0 ) {
+	  ll cid = next_conn++;
+	  conns[cid].fd = fd;
+	  epoll_event ce;
+	  ce.events = EPOLLIN | EPOLLRDHUP;
+	  ce.data.u64 = cid;
+	  epoll_ctl( ep, EPOLL_CTL_ADD, fd, &ce );
+	}
+	continue;
+      }
+
+      if ( id == WAKE ) {
+	uint64_t count;
+	if ( read( wake_fd, &count, sizeof( count ) ) < 0 ) { /* spurious */ }
+	while ( ServeJob* job = done.pop( false ) ) {
+	  auto it = conns.find( job->conn );
+	  if ( it != conns.end() ) {
+	    ServeConn& c = it->second;
+	    c.out += job->response.buf;
+	    c.pending--;
+	    if ( not flush( c ) ) drop( job->conn );
+	    else if ( c.eof and c.pending == 0 and c.out.empty() ) drop( job->conn );
+	    else watch( job->conn, c );
+	  }
+	  delete job;
+	}
+	continue;
+      }
+
+      auto it = conns.find( id );
+      if ( it == conns.end() ) continue;
+      ServeConn& c = it->second;
+      bool ok = not ( events[e].events & EPOLLERR );
+
+      if ( ok and ( events[e].events & ( EPOLLIN | EPOLLRDHUP | EPOLLHUP ) ) ) {
+	char buf[1 << 16];
+	while ( true ) {
+	  ssize_t r = recv( c.fd, buf, sizeof( buf ), 0 );
+	  if ( r > 0 ) c.in.append( buf, size_t( r ) );
+	  else if ( r == 0 ) { c.eof = true; break; }
+	  else if ( errno == EINTR ) continue;
+	  else { ok = ( errno == EAGAIN or errno == EWOULDBLOCK ); break; }
+	}
+	if ( ok ) ok = serve_parse( c, id, submit );
+      }
+      if ( ok ) ok = flush( c );
+
+      if ( not ok or ( c.eof and c.pending == 0 and c.out.empty() ) ) drop( id );
+      else watch( id, c );
+    }
+  }
+
+  pool.shutdown();
+  while ( ServeJob* job = done.pop( false ) ) delete job;
+  for ( auto& it: conns ) close( it.second.fd );
+  close( listen_fd );
+  close( wake_fd );
+  close( ep );
+  unlink( path.c_str() );
+
+  return 0;
+
+}
+
+#endif
+
+////////////////////////////////////////////////////////////////////////
+//
+// Command line
+//
+////////////////////////////////////////////////////////////////////////
+
+template<typename T>
+void print_array( ostream& os, const vector<T>& a ) {
+  os << "[";
+  for ( size_t i = 0; i < a.size(); i++ )
+    os << ( i ? "," : "" ) << a[i];
+  os << "]";
+}
+
+void print_perf( ostream& os, const PerfCounts& p, ll columns = -1LL ) {
+
+  os << "{\"calls\":" << p.calls;
+  for ( int i = 0; i < PERF_EVENTS; i++ ) {
+    os << ",\"" << perf_names[i] << "\":";
+    if ( perf.fd[i] < 0 ) os << "null";
+    else os << p.v[i];
+  }
+  os << ",\"ipc\":";
+  if ( perf.fd[0] < 0 or perf.fd[1] < 0 or p.v[0] == 0LL ) os << "null";
+  else os << double( p.v[1] )/double( p.v[0] );
+  if ( columns >= 0LL )
+    for ( int i = 2; i <= 3; i++ ) {
+      os << ",\"" << perf_names[i] << "_per_column\":";
+      if ( perf.fd[i] < 0 or columns == 0LL ) os << "null";
+      else os << double( p.v[i] )/double( columns );
+    }
+  os << "}";
+
+}
+
+void print_cache( ostream& os, const ResultCache& cache ) {
+
+  ll lookups = cache.hits+cache.near_hits+cache.misses;
+  os << "{\"entries\":" << cache.lru.size()
+     << ",\"bytes\":" << cache.bytes
+     << ",\"capacity\":" << cache.capacity
+     << ",\"hits\":" << cache.hits
+     << ",\"near_hits\":" << cache.near_hits
+     << ",\"misses\":" << cache.misses
+     << ",\"evictions\":" << cache.evictions
+     << ",\"hit_rate\":" << ( lookups ? double( cache.hits )/lookups : 0.0 ) << "}";
+
+}
+
+void print_stats( const HungarianSolver& s, const string& engine, const ResultCache* cache ) {
+
+  ostream& os = cerr;
+  const Timings& timings = s.timings;
+
+  os << "{\"n\":" << s.N << ",\"engine\":\"" << engine << "\"";
+  os << ",\"storage\":{\"kind\":\"" << s.storage() << "\"";
+  if ( s.storage() == "memory" )
+    os << ",\"pages\":\"" << s.c.pages << "\",\"numa\":\"" << s.c.placement
+       << "\",\"numa_nodes\":" << numa_nodes();
+  if ( s.file )
+    os << ",\"cache_rows\":" << s.file->rows
+       << ",\"row_reads\":" << s.file->row_reads
+       << ",\"row_hits\":" << s.file->row_hits;
+  if ( s.points )
+    os << ",\"d\":" << s.points->d << ",\"scale\":" << s.points->scale;
+  os << "}";
+  if ( s.has_deadline ) {
+    ll cost = s.assignment_cost(), bound = s.lower_bound();
+    os << ",\"anytime\":{\"stopped\":" << ( s.stopped ? "true" : "false" )
+       << ",\"rows_matched\":" << ( s.stopped ? s.matched_at_stop : s.N )
+       << ",\"cost\":" << cost << ",\"lower_bound\":" << bound
+       << ",\"gap\":" << cost-bound << "}";
+  }
+  if ( s.choice.made ) {
+    const EngineChoice& f = s.choice;
+    os << ",\"auto\":{\"engine\":\"" << f.engine << "\",\"rule\":\"" << f.rule << "\"";
+    if ( f.sampled )
+      os << ",\"sampled_rows\":" << f.sampled << ",\"min\":" << f.min_cost
+	 << ",\"max\":" << f.max_cost << ",\"spread\":" << f.spread
+	 << ",\"diversity\":" << f.diversity;
+    os << "}";
+  }
+  if ( s.decomposition.blocks ) {
+    const Decomposition& d = s.decomposition;
+    os << ",\"blocks\":{\"count\":" << d.blocks << ",\"largest\":" << d.largest;
+    if ( d.blocks > 1 )
+      os << ",\"threads\":" << d.threads << ",\"engine\":\"" << d.engine << "\"";
+    os << "}";
+  }
+  if ( engine == "pruned" )
+    os << ",\"pruning\":{\"k\":" << s.prune_k << ",\"rounds\":" << s.prune_rounds
+       << ",\"edges\":" << s.prune_edges << "}";
+  os << ",\"time\":{\"read_input\":" << timings.read_input
+     << ",\"initialization\":" << timings.initialization
+     << ",\"search\":" << timings.search
+     << ",\"output\":" << timings.output
+     << ",\"verify\":" << timings.verify << "}";
+#ifdef HUNGARIAN_STATS
+  Counters total = counters;
+  count_merge( total, merged );
+  os << ",\"counters\":{\"update_slack_calls\":" << total.update_slack_calls
+     << ",\"columns_scanned\":" << total.columns_scanned
+     << ",\"theta_steps\":" << total.theta_steps
+     << ",\"zero_theta_steps\":" << total.zero_theta_steps
+     << ",\"admissibles\":" << total.admissibles
+     << ",\"alpha_beta_columns\":" << total.alpha_beta_columns
+     << ",\"search_size\":";
+  print_array( os, total.search_size );
+  os << ",\"path_length\":";
+  print_array( os, total.path_length );
+  os << "}";
+#else
+  os << ",\"counters\":null";
+#endif
+  if ( perf.enabled ) {
+    os << ",\"perf\":{\"available\":true,\"phases\":{\"read_input\":";
+    print_perf( os, perf.read_input );
+    os << ",\"initialization\":";
+    print_perf( os, perf.initialization );
+    os << ",\"search\":";
+    print_perf( os, perf.search );
+    os << ",\"output\":";
+    print_perf( os, perf.output );
+    os << "}";
+#ifdef HUNGARIAN_STATS
+    os << ",\"kernels\":{\"update_slack\":";
+    // the kernels are only perf sampled on this thread (see perf_begin)
+    print_perf( os, perf.update_slack, counters.columns_scanned );
+    os << ",\"update_alpha_beta\":";
+    print_perf( os, perf.update_alpha_beta, counters.alpha_beta_columns );
+    os << "}";
+#endif
+    os << "}";
+  } else if ( not perf.error.empty() )
+    os << ",\"perf\":{\"available\":false,\"error\":\"" << perf.error << "\"}";
+  if ( cache ) {
+    os << ",\"cache\":";
+    print_cache( os, *cache );
+  }
+  os << "}" << endl;
+
+}
+
+////////////////////////////////////////////////////////////////////////
+//
+// Compressed input: a gzip (-DHUNGARIAN_ZLIB) or zstd
+// (-DHUNGARIAN_ZSTD) standard input is recognised by its magic bytes
+// and decoded by a thread of its own into a pipe that takes the place
+// of the standard input. Parsing (the stream reader of read_input or
+// the batch reader) starts on the first decoded block and runs
+// alongside the decoder, and the pipe bounds how far the decoder runs
+// ahead. The Makefile sets the flags when the headers are installed.
+// A plain pipe is read directly: the bytes read to check it are handed
+// to the reader as a prefix (InputDecoder::prefix, and through cin for
+// the readers that use it); a plain file is left alone for the mmap
+// parser.
+//
+////////////////////////////////////////////////////////////////////////
+
+const size_t DECODE_BLOCK = size_t( 1 ) << 17;
+
+// false if the reader is gone
+bool write_fully( int fd, const char* p, size_t size ) {
+  while ( size > 0 ) {
+    ssize_t w = write( fd, p, size );
+    if ( w < 0 and errno == EINTR ) continue;
+    if ( w <= 0 ) return false;
+    p += w;
+    size -= size_t( w );
+  }
+  return true;
+}
+
+// next block of in after the bytes in head; 0 at the end
+ssize_t read_block( int in, string& head, vector<char>& buf ) {
+  if ( not head.empty() ) {
+    size_t size = head.size();
+    memcpy( buf.data(), head.data(), size );
+    head.clear();
+    return ssize_t( size );
+  }
+  while ( true ) {
+    ssize_t r = read( in, buf.data(), buf.size() );
+    if ( r < 0 and errno == EINTR ) continue;
+    return r;
+  }
+}
+
+// the decoders return an empty string at the end of the stream, or if
+// the reader went away, else the reason they stopped
+
+#ifdef HUNGARIAN_ZLIB
+string decode_gzip( int in, string head, int out ) {
+
+  z_stream z;
+  memset( &z, 0, sizeof( z ) );
+  if ( inflateInit2( &z, 15+32 ) != Z_OK ) return "cannot start the gzip decoder";
+  vector<char> src( DECODE_BLOCK ), dst( DECODE_BLOCK );
+  string error;
+  bool ended = false;       // the last member is complete
+  ssize_t r;
+  while ( error.empty() and ( r = read_block( in, head, src ) ) > 0 ) {
+    z.next_in = (Bytef*)( src.data() );
+    z.avail_in = uInt( r );
+    do {
+      z.next_out = (Bytef*)( dst.data() );
+      z.avail_out = uInt( dst.size() );
+      int rc = inflate( &z, Z_NO_FLUSH );
+      ended = rc == Z_STREAM_END;
+      if ( ended ) inflateReset( &z );  // concatenated members
+      else if ( rc != Z_OK and rc != Z_BUF_ERROR ) {
+	error = "corrupt gzip input";
+	break;
+      }
+      if ( not write_fully( out, dst.data(), dst.size()-z.avail_out ) ) {
+	inflateEnd( &z );
+	return "";
+      }
+      // a member that ends with the block: the reset stream has nothing
+      // to inflate until more input comes
+      if ( ended and z.avail_in == 0 ) break;
+    } while ( z.avail_in > 0 or z.avail_out == 0 );
+  }
+  inflateEnd( &z );
+  if ( error.empty() and r < 0 ) error = string( "read error: " )+strerror( errno );
+  if ( error.empty() and not ended ) error = "truncated gzip input";
+  return error;
+
+}
+#endif
+
+#ifdef HUNGARIAN_ZSTD
+string decode_zstd( int in, string head, int out ) {
+
+  ZSTD_DCtx* d = ZSTD_createDCtx();
+  if ( d == nullptr ) return "cannot start the zstd decoder";
+  vector<char> src( DECODE_BLOCK ), dst( DECODE_BLOCK );
+  string error;
+  size_t pending = 0;       // nonzero inside a frame
+  ssize_t r;
+  while ( error.empty() and ( r = read_block( in, head, src ) ) > 0 ) {
+    ZSTD_inBuffer ib = { src.data(), size_t( r ), 0 };
+    while ( ib.pos < ib.size or pending > 0 ) {
+      ZSTD_outBuffer ob = { dst.data(), dst.size(), 0 };
+      pending = ZSTD_decompressStream( d, &ob, &ib );
+      if ( ZSTD_isError( pending ) ) {
+	error = string( "corrupt zstd input: " )+ZSTD_getErrorName( pending );
+	break;
+      }
+      if ( not write_fully( out, dst.data(), ob.pos ) ) {
+	ZSTD_freeDCtx( d );
+	return "";
+      }
+      if ( ib.pos == ib.size and ob.pos < ob.size ) break;  // needs input
+    }
+  }
+  ZSTD_freeDCtx( d );
+  if ( error.empty() and r < 0 ) error = string( "read error: " )+strerror( errno );
+  if ( error.empty() and pending > 0 ) error = "truncated zstd input";
+  return error;
+
+}
+#endif
+
+// cin of a plain pipe: the peeked bytes, then the standard input
+struct PrefixedInput : streambuf {
+
+  vector<char> buf;
+
+  explicit PrefixedInput( const string& prefix ) : buf( max( DECODE_BLOCK, prefix.size() ) ) {
+    memcpy( buf.data(), prefix.data(), prefix.size() );
+    setg( buf.data(), buf.data(), buf.data()+prefix.size() );
+  }
+
+  int_type underflow() override {
+    ssize_t r;
+    do r = read( STDIN_FILENO, buf.data(), buf.size() ); while ( r < 0 and errno == EINTR );
+    if ( r <= 0 ) return traits_type::eof();
+    setg( buf.data(), buf.data(), buf.data()+r );
+    return traits_type::to_int_type( buf[0] );
+  }
+
+};
+
+struct InputDecoder {
+
+  thread worker;
+  string kind = "plain", error;
+  string prefix;                     // read from a plain pipe by open
+  unique_ptr<PrefixedInput> cin_buf;
+  streambuf* cin_old = nullptr;
+
+  // empty on success, else the reason
+  string open() {
+
+    struct stat st;
+    bool regular = fstat( STDIN_FILENO, &st ) == 0 and S_ISREG( st.st_mode );
+    off_t at = regular ? lseek( STDIN_FILENO, 0, SEEK_CUR ) : -1;
+    regular = regular and at >= 0;
+
+    string head( 4, '\0' );
+    size_t got = 0;
+    while ( got < head.size() ) {
+      ssize_t r = regular ? pread( STDIN_FILENO, &head[got], head.size()-got, at+off_t( got ) )
+	: read( STDIN_FILENO, &head[got], head.size()-got );
+      if ( r < 0 and errno == EINTR ) continue;
+      if ( r <= 0 ) break;
+      got += size_t( r );
+    }
+    head.resize( got );
+    if ( head.compare( 0, 2, "\x1f\x8b" ) == 0 ) kind = "gzip";
+    else if ( head == "\x28\xb5\x2f\xfd" ) kind = "zstd";
+    if ( kind == "plain" and regular ) return "";
+    if ( regular ) head.clear();     // pread did not consume it
+    if ( kind == "plain" ) {
+      prefix = head;
+      cin_buf.reset( new PrefixedInput( prefix ) );
+      cin_old = cin.rdbuf( cin_buf.get() );
+      return "";
+    }
+
+    string (*decode)( int, string, int ) = nullptr;
+#ifdef HUNGARIAN_ZLIB
+    if ( kind == "gzip" ) decode = decode_gzip;
+#else
+    if ( kind == "gzip" ) return "gzip input needs a build with zlib (-DHUNGARIAN_ZLIB)";
+#endif
+#ifdef HUNGARIAN_ZSTD
+    if ( kind == "zstd" ) decode = decode_zstd;
+#else
+    if ( kind == "zstd" ) return "zstd input needs a build with libzstd (-DHUNGARIAN_ZSTD)";
+#endif
+
+    int fds[2];
+    if ( pipe( fds ) < 0 ) return string( "pipe: " )+strerror( errno );
+    int in = dup( STDIN_FILENO );
+    dup2( fds[0], STDIN_FILENO );
+    close( fds[0] );
+    signal( SIGPIPE, SIG_IGN );      // the parser may stop reading first
+    int out = fds[1];
+    worker = thread( [this,decode,in,head,out]() {
+      error = decode( in, head, out );
+      close( out );
+      close( in );
+    } );
+    return "";
+
+  }
+
+  // stops reading and returns the decoder's error, if any
+  string close_input() {
+    if ( not worker.joinable() ) return error;
+    close( STDIN_FILENO );
+    worker.join();
+    return error;
+  }
+
+  ~InputDecoder() {
+    close_input();
+    if ( cin_old ) cin.rdbuf( cin_old );
+  }
+
+};
+
+////////////////////////////////////////////////////////////////////////
+//
+// Batch mode ("--batch"): the standard input holds any number of
+// instances one after the other, and their results are written in the
+// same order. Reading, parsing, solving and writing overlap in a
+// pipeline of threads joined by bounded single-producer
+// single-consumer rings:
+//
+//   reader --> parser[w] --> solver[w] --> writer     w = k % lanes
+//
+// The reader cuts the input into instance texts and deals instance k
+// to lane k % lanes, and the writer collects the lanes in the same
+// order, so no reordering is needed. A fixed set of BatchItems (text,
+// solver workspace, output) goes from the writer back to the reader,
+// which waits for a free one: that bounds the memory in flight and
+// recycles the buffers instead of reallocating them.
+//
+////////////////////////////////////////////////////////////////////////
+
+template<typename T>
+struct SpscRing {
+
+  vector<T> slot;
+  size_t mask;
+  atomic<size_t> head{ 0 };             // next pop, owned by the consumer
+  char pad[64];                         // keeps head and tail apart
+  atomic<size_t> tail{ 0 };             // next push, owned by the producer
+
+  explicit SpscRing( size_t capacity ) {
+    size_t size = 1;
+    while ( size < capacity ) size *= 2;
+    slot.resize( size );
+    mask = size-1;
+  }
+
+  bool push( const T& x ) {
+    size_t t = tail.load( memory_order_relaxed );
+    if ( t-head.load( memory_order_acquire ) > mask ) return false;
+    slot[t & mask] = x;
+    tail.store( t+1, memory_order_release );
+    return true;
+  }
+
+  bool pop( T& x ) {
+    size_t h = head.load( memory_order_relaxed );
+    if ( h == tail.load( memory_order_acquire ) ) return false;
+    x = slot[h & mask];
+    head.store( h+1, memory_order_release );
+    return true;
+  }
+
+  void put( const T& x ) {
+    while ( not push( x ) )
+      wait( [this]() {
+	return tail.load( memory_order_relaxed )-head.load( memory_order_acquire ) <= mask;
+      } );
+    wake();
+  }
+
+  T take() {
+    T x;
+    while ( not pop( x ) )
+      wait( [this]() {
+	return head.load( memory_order_relaxed ) != tail.load( memory_order_acquire );
+      } );
+    wake();
+    return x;
+  }
+
+  // An idle side spins for SPSC_SPINS yields, then sleeps on cv until
+  // the other side's wake; at most one side can be waiting (a ring is
+  // not full and empty at once). The fences order the waiting count
+  // against head and tail, so a wake cannot miss a sleeper.
+  static const int SPSC_SPINS = 64;
+  mutex m;
+  condition_variable cv;
+  atomic<int> waiting{ 0 };
+
+  template<typename F>
+  void wait( F ready ) {
+    for ( int spin = 0; spin < SPSC_SPINS; spin++ ) {
+      if ( ready() ) return;
+      this_thread::yield();
+    }
+    unique_lock<mutex> lock( m );
+    waiting.fetch_add( 1 );
+    atomic_thread_fence( memory_order_seq_cst );
+    cv.wait( lock, ready );
+    waiting.fetch_sub( 1 );
+  }
+
+  void wake() {
+    atomic_thread_fence( memory_order_seq_cst );
+    if ( waiting.load( memory_order_relaxed ) > 0 ) {
+      lock_guard<mutex> lock( m );
+      cv.notify_one();
+    }
+  }
+
+};
+
+const int BATCH_ITEMS_PER_LANE = 4;
+
+struct BatchItem {
+  string text;                  // the instance as read
+  HungarianSolver s;
+  string error;                 // why it has no result
+  OutputBuffer out;
+  double read = 0.0, parse = 0.0, solve = 0.0;   // seconds per stage
+};
+
+// cuts a stream into instance texts ("N" and N*N numbers each)
+struct BatchReader {
+
+  int fd;
+  vector<char> block = vector<char>( 1 << 16 );
+  size_t pos = 0, size = 0;
+
+  // prefix: what was already read from fd (see InputDecoder::open)
+  BatchReader( int fd, const string& prefix ) : fd( fd ) {
+    if ( prefix.size() > block.size() ) block.resize( prefix.size() );
+    memcpy( block.data(), prefix.data(), prefix.size() );
+    size = prefix.size();
+  }
+
+  // false at the end of the input; a truncated last instance is
+  // returned as it is (parse_text reports it)
+  bool next( string& text ) {
+
+    text.clear();
+    ll n = 0, need = -1, tokens = 0;
+    bool in = false;
+    while ( tokens != need ) {
+      if ( pos == size ) {
+	ssize_t r = read( fd, block.data(), block.size() );
+	if ( r < 0 and errno == EINTR ) continue;
+	if ( r <= 0 ) break;
+	pos = 0;
+	size = size_t( r );
+      }
+      size_t from = pos;
+      for ( ; pos < size and tokens != need; pos++ ) {
+	char ch = block[pos];
+	if ( not HungarianSolver::is_space( ch ) ) {
+	  if ( need < 0 and ch >= '0' and ch <= '9' ) n = min( 10*n+( ch-'0' ), 1LL << 31 );
+	  in = true;
+	} else if ( in ) {
+	  in = false;
+	  if ( need < 0 ) need = 1+n*n;
+	  tokens++;
+	}
+      }
+      text.append( block.data()+from, pos-from );
+    }
+    return tokens > 0 or in;
+
+  }
+
+};
+
+// returns the exit status
+int run_batch( int lanes, const string& engine, const string& format, bool verify,
+	       int prune_k, ResultCache* cache, bool stats, const string& prefix ) {
+
+  typedef SpscRing<BatchItem*> Ring;
+  int items = BATCH_ITEMS_PER_LANE*lanes;
+  Ring free_items( items );
+  vector<unique_ptr<Ring>> parse_q, solve_q, write_q;
+  for ( int w = 0; w < lanes; w++ ) {
+    parse_q.emplace_back( new Ring( items ) );
+    solve_q.emplace_back( new Ring( items ) );
+    write_q.emplace_back( new Ring( items ) );
+  }
+  vector<unique_ptr<BatchItem>> owned;
+  for ( int i = 0; i < items; i++ ) {
+    owned.emplace_back( new BatchItem() );
+    owned.back()->s.prune_k = prune_k;
+    free_items.put( owned.back().get() );
+  }
+
+  Clock::time_point t0 = Clock::now();
+  vector<thread> pool;
+
+  pool.emplace_back( [&]() {
+    BatchReader in( STDIN_FILENO, prefix );
+    for ( ll k = 0; ; k++ ) {
+      BatchItem* item = free_items.take();
+      Clock::time_point t = Clock::now();
+      if ( not in.next( item->text ) ) {
+	free_items.put( item );
+	break;
+      }
+      item->read = seconds_since( t );
+      parse_q[k%lanes]->put( item );
+    }
+    for ( int w = 0; w < lanes; w++ ) parse_q[w]->put( nullptr );
+  } );
+
+  for ( int w = 0; w < lanes; w++ ) {
+    pool.emplace_back( [&,w]() {
+      while ( BatchItem* item = parse_q[w]->take() ) {
+	Clock::time_point t = Clock::now();
+	const char* text = item->text.data();
+	item->error = item->s.parse_text( text, text+item->text.size(), 1 );
+	item->parse = seconds_since( t );
+	solve_q[w]->put( item );
+      }
+      solve_q[w]->put( nullptr );
+    } );
+    pool.emplace_back( [&,w]() {
+      while ( BatchItem* item = solve_q[w]->take() ) {
+	Clock::time_point t = Clock::now();
+	HungarianSolver& s = item->s;
+	if ( item->error.empty() and solve_cached( s, engine, cache ).empty() )
+	  item->error = "engine " + engine + " cannot solve N = " + to_string( s.N );
+	if ( item->error.empty() and verify and not s.stopped ) {
+	  string error = s.verify_certificate();
+	  if ( not error.empty() ) item->error = "verification failed: " + error;
+	}
+	if ( item->error.empty() ) write_output( item->out, s, format );
+	item->solve = seconds_since( t );
+	write_q[w]->put( item );
+      }
+      write_q[w]->put( nullptr );
+    } );
+  }
+
+  // the writer: results in input order
+  int status = 0;
+  ll done = 0;
+  double read = 0.0, parse = 0.0, solve = 0.0, write = 0.0;
+  bool writable = true;
+  while ( BatchItem* item = write_q[done%lanes]->take() ) {
+    done++;
+    Clock::time_point t = Clock::now();
+    if ( not item->error.empty() ) {
+      cerr << "hungarian: instance " << done << ": " << item->error << endl;
+      status = 1;
+    } else if ( writable and not item->out.flush( STDOUT_FILENO ) ) {
+      cerr << "hungarian: write error: " << strerror( errno ) << endl;
+      writable = false;
+      status = 1;
+    }
+    item->out.buf.clear();
+    write += seconds_since( t );
+    read += item->read;
+    parse += item->parse;
+    solve += item->solve;
+    free_items.put( item );
+  }
+  // the other lanes have ended too (instances are dealt in order)
+  for ( int w = 0; w < lanes; w++ )
+    if ( w != done%lanes ) write_q[w]->take();
+  for ( thread& th: pool ) th.join();
+
+  if ( stats ) {
+    double seconds = seconds_since( t0 );
+    cerr << "{\"batch\":{\"instances\":" << done << ",\"lanes\":" << lanes
+	 << ",\"seconds\":" << seconds
+	 << ",\"instances_per_s\":" << ( seconds > 0.0 ? done/seconds : 0.0 )
+	 << ",\"busy\":{\"read\":" << read << ",\"parse\":" << parse
+	 << ",\"solve\":" << solve << ",\"write\":" << write << "}}";
+    if ( cache ) {
+      cerr << ",\"cache\":";
+      print_cache( cerr, *cache );
+    }
+    cerr << "}" << endl;
+  }
+  return status;
+
+}
+
+// "--capacitated": one instance from the standard input; returns the
+// exit status
+int run_capacitated( InputDecoder& decoder, const string& format, bool verify, bool stats ) {
+
+  CapacitatedSolver s;
+  Clock::time_point t0 = Clock::now();
+  string error = s.read_input();
+  string decode_error = decoder.close_input();
+  if ( not decode_error.empty() ) error = decode_error;
+  if ( not error.empty() ) {
+    cerr << "hungarian: " << error << endl;
+    return 1;
+  }
+  s.timings.read_input = seconds_since( t0 );
+
+  s.solve();
+
+  if ( verify ) {
+    t0 = Clock::now();
+    error = s.verify_certificate();
+    s.timings.verify = seconds_since( t0 );
+    if ( not error.empty() ) {
+      cerr << "hungarian: verification failed: " << error << endl;
+      return 2;
+    }
+  }
+
+  t0 = Clock::now();
+  OutputBuffer out;
+  write_output( out, s, format );
+  if ( not out.flush( STDOUT_FILENO ) ) {
+    cerr << "hungarian: write error: " << strerror( errno ) << endl;
+    return 1;
+  }
+  s.timings.output = seconds_since( t0 );
+
+  if ( stats )
+    cerr << "{\"n\":" << s.n << ",\"m\":" << s.m << ",\"capacity\":" << s.total_capacity
+	 << ",\"engine\":\"capacitated\",\"cost\":" << s.assignment_cost()
+	 << ",\"dual_bound\":" << s.dual_bound()
+	 << ",\"time\":{\"read_input\":" << s.timings.read_input
+	 << ",\"initialization\":" << s.timings.initialization
+	 << ",\"search\":" << s.timings.search
+	 << ",\"output\":" << s.timings.output
+	 << ",\"verify\":" << s.timings.verify << "}}" << endl;
+  return 0;
+
+}
+
+////////////////////////////////////////////////////////////////////////
+//
+// C API (hungarian.h), built into libhungarian.so with
+// -DHUNGARIAN_LIBRARY. A workspace is a HungarianSolver that is kept
+// between calls; results go straight into the caller's arrays. A pool
+// is a SolvePool (the one of --serve) whose tasks borrow the caller's
+// matrix and report through the caller's callback.
+//
+////////////////////////////////////////////////////////////////////////
+
+#ifdef HUNGARIAN_LIBRARY
+
+struct hungarian_workspace {
+  HungarianSolver s;
+  string engine = "auto";
+  bool copy = false;            // see hungarian_set_copy
+  atomic<bool> cancel{ false };
+};
+
+struct hungarian_pool {
+  SolvePool pool;
+  hungarian_pool( int threads, double slice ) : pool( threads, slice, nullptr ) {}
+};
+
+// the engine named e, or nullptr if there is none
+const char* engine_name( const char* e ) {
+  for ( const char* name: { "auto", "fixed", "dense", "packed", "pruned" } )
+    if ( strcmp( e, name ) == 0 ) return name;
+  return nullptr;
+}
+
+// the arguments hungarian_solve and hungarian_submit share
+bool valid_matrix( int n, const void* costs, size_t stride, int type ) {
+  size_t size = type == HUNGARIAN_INT32 ? 4 : 8;
+  return n >= 0 and ( n == 0 or costs ) and
+    ( type == HUNGARIAN_INT32 or type == HUNGARIAN_INT64 ) and
+    ( n <= 1 or stride >= size*size_t( n ) );
+}
+
+extern "C" {
+
+int hungarian_api_version( void ) { return HUNGARIAN_API_VERSION; }
+
+hungarian_workspace* hungarian_workspace_create( void ) {
+  hungarian_workspace* w = new (nothrow) hungarian_workspace();
+  if ( w ) w->s.cancel = &w->cancel;
+  return w;
+}
+
+void hungarian_cancel( hungarian_workspace* w ) {
+  if ( w ) w->cancel.store( true, memory_order_relaxed );
+}
+
+int hungarian_set_progress( hungarian_workspace* w, hungarian_progress_fn fn, void* user ) {
+
+  if ( not w ) return HUNGARIAN_EINVAL;
+  if ( not fn ) w->s.progress = nullptr;
+  else {
+    try {
+      w->s.progress = [fn,user,w]( int matched, ll bound ) {
+	fn( user, matched, w->s.N, bound );
+      };
+    } catch ( ... ) {
+      return HUNGARIAN_ENOMEM;
+    }
+  }
+  return HUNGARIAN_OK;
+
+}
+
+void hungarian_workspace_destroy( hungarian_workspace* w ) { delete w; }
+
+int hungarian_set_engine( hungarian_workspace* w, const char* engine ) {
+
+  const char* e = engine ? engine_name( engine ) : nullptr;
+  if ( not w or not e ) return HUNGARIAN_EINVAL;
+  w->engine.assign( e );        // fits in the short string buffer
+  return HUNGARIAN_OK;
+
+}
+
+int hungarian_set_copy( hungarian_workspace* w, int copy ) {
+
+  if ( not w ) return HUNGARIAN_EINVAL;
+  w->copy = copy != 0;
+  return HUNGARIAN_OK;
+
+}
+
+int hungarian_solve( hungarian_workspace* w, int n, const void* costs, size_t stride, int type,
+		     int32_t* row_to_col, int64_t* alpha, int64_t* beta, int64_t* cost ) {
+
+  if ( not w or not valid_matrix( n, costs, stride, type ) )
+    return HUNGARIAN_EINVAL;
+
+  HungarianSolver& s = w->s;
+  string used;
+  try {
+    if ( not w->copy ) s.borrow( n, (const char*)( costs ), stride, type == HUNGARIAN_INT64 );
+    else if ( type == HUNGARIAN_INT32 ) s.load_strided<int32_t>( n, (const char*)( costs ), stride );
+    else s.load_strided<int64_t>( n, (const char*)( costs ), stride );
+    used = solve( s, w->engine );
+  } catch ( const bad_alloc& ) {
+    w->cancel.store( false );
+    return HUNGARIAN_ENOMEM;
+  } catch ( ... ) {
+    // no exception may cross the C boundary
+    w->cancel.store( false );
+    return HUNGARIAN_EINTERNAL;
+  }
+  // a cancel that arrived during (or before) this solve is used up
+  w->cancel.store( false );
+  if ( used.empty() ) return HUNGARIAN_EENGINE;
+  if ( s.cancelled ) return HUNGARIAN_ECANCELLED;
+
+  for ( int v = 0; v < n; v++ ) {
+    if ( row_to_col ) row_to_col[v] = s.mate_V[v];
+    if ( alpha ) alpha[v] = s.alpha[v];
+    if ( beta ) beta[v] = s.beta[v];
+  }
+  if ( cost ) *cost = s.optimal_cost();
+  return HUNGARIAN_OK;
+
+}
+
+hungarian_pool* hungarian_pool_create( int threads, double slice_ms ) {
+
+  if ( threads <= 0 ) threads = max( 1u, thread::hardware_concurrency() );
+  try {
+    return new hungarian_pool( threads, 1e-3*max( slice_ms, 0.0 ) );
+  } catch ( ... ) {
+    return nullptr;             // out of memory or threads
+  }
+
+}
+
+void hungarian_pool_destroy( hungarian_pool* p ) { delete p; }
+
+int hungarian_submit( hungarian_pool* p, const char* engine, int n,
+		      const void* costs, size_t stride, int type,
+		      int32_t* row_to_col, int64_t* alpha, int64_t* beta, int64_t* cost,
+		      hungarian_done_fn done, void* user ) {
+
+  const char* e = engine_name( engine ? engine : "auto" );
+  if ( not p or not e or not done or not valid_matrix( n, costs, stride, type ) )
+    return HUNGARIAN_EINVAL;
+
+  const char* m = (const char*)( costs );
+  bool wide = type == HUNGARIAN_INT64;
+  SolveTask* t = nullptr;
+  try {
+    shared_ptr<int> status = make_shared<int>( HUNGARIAN_OK );
+    t = new SolveTask();
+    t->engine = e;
+    // on the worker: a failed borrow leaves an empty instance behind
+    t->load = [=]( HungarianSolver& s ) {
+      try {
+	s.borrow( n, m, stride, wide );
+      } catch ( ... ) {
+	*status = HUNGARIAN_ENOMEM;
+	s.load( 0, nullptr );
+      }
+    };
+    t->done = [=]( HungarianSolver* s, const string& used ) {
+      int r = *status;
+      if ( r == HUNGARIAN_OK ) {
+	if ( not s ) r = HUNGARIAN_ECANCELLED;
+	else if ( used.empty() ) r = HUNGARIAN_EENGINE;
+	else {
+	  for ( int v = 0; v < n; v++ ) {
+	    if ( row_to_col ) row_to_col[v] = s->mate_V[v];
+	    if ( alpha ) alpha[v] = s->alpha[v];
+	    if ( beta ) beta[v] = s->beta[v];
+	  }
+	  if ( cost ) *cost = s->optimal_cost();
+	}
+      }
+      done( user, r );
+    };
+    p->pool.submit( t );
+  } catch ( ... ) {
+    delete t;
+    return HUNGARIAN_ENOMEM;
+  }
+  return HUNGARIAN_OK;
+
+}
+
+}
+
+#else
+
+int main(int argc, char* argv[]) {
+
+  ios::sync_with_stdio(false);
+  cin.tie(nullptr);
+
+  bool stats = false, verify = false, batch = false, capacitated = false;
+  string format = "cost";
+  string engine = "auto";
+  string serve_path, matrix_path, metric;
+  ll row_cache_mb = 1024;
+  double scale = 1.0;
+  int candidates = 16;
+  double deadline_ms = -1.0;
+  double slice_ms = 0.0;
+  string tune_path;
+  int threads = 0;
+  ll cache_mb = 0;
+  bool has_forbidden = false;
+  ll forbidden = 0LL;
+  for ( int i = 1; i < argc; i++ ) {
+    string opt = argv[i];
+    if ( opt == "-m" or opt == "--match" or opt == "--match=text" )
+      format = "match";
+    else if ( opt == "--match=binary" )
+      format = "binary";
+    else if ( opt == "--json" )
+      format = "json";
+    else if ( opt.compare( 0, 9, "--engine=" ) == 0 )
+      engine = opt.substr( 9 );
+    else if ( opt.compare( 0, 10, "--threads=" ) == 0 )
+      threads = atoi( opt.c_str()+10 );
+    else if ( opt.compare( 0, 9, "--matrix=" ) == 0 )
+      matrix_path = opt.substr( 9 );
+    else if ( opt.compare( 0, 12, "--row-cache=" ) == 0 )
+      row_cache_mb = atoll( opt.c_str()+12 );
+    else if ( opt.compare( 0, 11, "--deadline=" ) == 0 )
+      deadline_ms = atof( opt.c_str()+11 );
+    else if ( opt.compare( 0, 7, "--tune=" ) == 0 )
+      tune_path = opt.substr( 7 );
+    else if ( opt.compare( 0, 8, "--slice=" ) == 0 )
+      slice_ms = max( 0.0, atof( opt.c_str()+8 ) );
+    else if ( opt == "--no-huge-pages" )
+      matrix_policy.huge_pages = false;
+    else if ( opt == "--numa=off" )
+      matrix_policy.numa = NUMA_OFF;
+    else if ( opt == "--numa=interleave" )
+      matrix_policy.numa = NUMA_INTERLEAVE;
+    else if ( opt == "--numa=partition" )
+      matrix_policy.numa = NUMA_PARTITION;
+    else if ( opt.compare( 0, 9, "--points=" ) == 0 )
+      metric = opt.substr( 9 );
+    else if ( opt.compare( 0, 13, "--candidates=" ) == 0 )
+      candidates = atoi( opt.c_str()+13 );
+    else if ( opt.compare( 0, 8, "--scale=" ) == 0 )
+      scale = atof( opt.c_str()+8 );
+    else if ( opt.compare( 0, 8, "--cache=" ) == 0 )
+      cache_mb = atoll( opt.c_str()+8 );
+    else if ( opt.compare( 0, 12, "--forbidden=" ) == 0 ) {
+      has_forbidden = true;
+      forbidden = atoll( opt.c_str()+12 );
+    }
+    else if ( opt == "--serve" and i+1 < argc )
+      serve_path = argv[++i];
+    else if ( opt.compare( 0, 8, "--serve=" ) == 0 )
+      serve_path = opt.substr( 8 );
+    else if ( opt == "--batch" )
+      batch = true;
+    else if ( opt == "--capacitated" )
+      capacitated = true;
+    else if ( opt == "--stats" )
+      stats = report_features = true;
+    else if ( opt == "--verify" )
+      verify = true;
+    else if ( opt == "--perf" ) {
+      stats = report_features = true;
+      perf_open();
+    }
+  }
+
+  if ( threads <= 0 ) threads = max( 1u, thread::hardware_concurrency() );
+
+  // only the dense engine can stop at a deadline ("auto" picks it)
+  if ( deadline_ms >= 0.0 and engine != "auto" and engine != "dense" ) {
+    cerr << "hungarian: --deadline needs the dense engine, not " << engine << endl;
+    return 1;
+  }
+
+  // --batch solves square text instances whole, one after the other
+  if ( batch ) {
+    const char* option = deadline_ms >= 0.0 ? "--deadline" : has_forbidden ? "--forbidden" :
+      not metric.empty() ? "--points" : not matrix_path.empty() ? "--matrix" :
+      capacitated ? "--capacitated" : nullptr;
+    if ( option ) {
+      cerr << "hungarian: " << option << " cannot be used with --batch" << endl;
+      return 1;
+    }
+  }
+
+  if ( not tune_path.empty() ) {
+    string error = load_tune( tune_path );
+    if ( not error.empty() ) {
+      cerr << "hungarian: " << error << endl;
+      return 1;
+    }
+  }
+
+  unique_ptr<ResultCache> cache;
+  if ( cache_mb > 0 ) cache.reset( new ResultCache( size_t( cache_mb ) << 20 ) );
+
+  if ( not serve_path.empty() ) {
+#ifdef __linux__
+    int status = serve( serve_path, threads, 1e-3*slice_ms, cache.get() );
+    if ( stats and cache ) {
+      cerr << "{\"cache\":";
+      print_cache( cerr, *cache );
+      cerr << "}" << endl;
+    }
+    return status;
+#else
+    cerr << "hungarian: --serve is Linux only" << endl;
+    return 1;
+#endif
+  }
+
+  InputDecoder decoder;
+  if ( matrix_path.empty() ) {
+    string error = decoder.open();
+    if ( not error.empty() ) {
+      cerr << "hungarian: " << error << endl;
+      return 1;
+    }
+  }
+
+  if ( capacitated ) return run_capacitated( decoder, format, verify, stats );
+
+  if ( batch ) {
+    int status = run_batch( threads, engine, format, verify, candidates, cache.get(), stats,
+			    decoder.prefix );
+    string error = decoder.close_input();
+    if ( not error.empty() ) {
+      cerr << "hungarian: " << error << endl;
+      status = 1;
+    }
+    return status;
+  }
+
+  HungarianSolver s;
+  s.prune_k = candidates;
+
+  Clock::time_point t0 = Clock::now();
+  perf_begin( perf.read_input );
+  string error;
+  if ( not matrix_path.empty() )
+    error = s.open_matrix( matrix_path, size_t( max( row_cache_mb, 0LL ) ) << 20 );
+  else if ( not metric.empty() )
+    error = s.read_points( metric, scale );
+  else error = s.read_input( threads, decoder.prefix );
+  string decode_error = decoder.close_input();
+  if ( not decode_error.empty() ) error = decode_error;
+  if ( error.empty() and has_forbidden ) error = forbid( s, forbidden );
+  if ( not error.empty() ) {
+    cerr << "hungarian: " << error << endl;
+    return 1;
+  }
+  perf_end( perf.read_input );
+  s.timings.read_input = seconds_since( t0 );
+
+  if ( deadline_ms >= 0.0 ) {
+    s.has_deadline = true;
+    s.deadline = Clock::now()+chrono::microseconds( ll( deadline_ms*1000.0 ) );
+  }
+  string used;
+  if ( has_forbidden ) {
+    used = solve_blocks( s, engine, threads, cache.get(), error );
+    if ( not error.empty() ) {
+      cerr << "hungarian: " << error << endl;
+      return 1;
+    }
+  } else used = solve_cached( s, engine, cache.get() );
+  if ( used.empty() ) {
+    if ( engine == "fixed" )
+      cerr << "hungarian: fixed engine needs 1 <= N <= " << FIXED_MAX_N << endl;
+    else
+      cerr << "hungarian: unknown engine " << engine << endl;
+    return 1;
+  }
+
+  if ( s.stopped ) {
+    ll cost = s.assignment_cost(), bound = s.lower_bound();
+    cerr << "hungarian: deadline reached with " << s.matched_at_stop << " of " << s.N
+	 << " rows matched on tight edges; cost " << cost << ", lower bound " << bound
+	 << ", gap " << cost-bound << endl;
+  }
+
+  if ( verify and s.stopped )
+    cerr << "hungarian: not verified, the solution is not optimal" << endl;
+  else if ( verify ) {
+    t0 = Clock::now();
+    string error = s.verify_certificate( s.N >= 1000 ? threads : 1 );
+    s.timings.verify = seconds_since( t0 );
+    if ( not error.empty() ) {
+      cerr << "hungarian: verification failed: " << error << endl;
+      return 2;
+    }
+  }
+
+  t0 = Clock::now();
+  perf_begin( perf.output );
+  OutputBuffer out;
+  write_output( out, s, format );
+  if ( not out.flush( STDOUT_FILENO ) ) {
+    cerr << "hungarian: write error: " << strerror( errno ) << endl;
+    return 1;
+  }
+  perf_end( perf.output );
+  s.timings.output = seconds_since( t0 );
+
+  if ( stats ) print_stats( s, used, cache.get() );
+
+  return 0;
+
+}
+
+#endif
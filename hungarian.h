@@ -0,0 +1,169 @@
+////////////////////////////////////////////////////////////////////////
+//
+// C API of libhungarian.so ("make libhungarian.so")
+//
+// The cost matrix stays owned by the caller: it is read in place,
+// through a pointer, a row stride in bytes and an element type, and
+// must not change during the solve; the results are written into
+// caller-provided arrays. A workspace keeps its O(n) solver memory
+// between calls, so a solve of a size already seen does not allocate;
+// hungarian_set_copy trades n x n more of it for speed.
+//
+//   hungarian_workspace* w = hungarian_workspace_create();
+//   int32_t row_to_col[n];
+//   int64_t cost;
+//   hungarian_solve( w, n, costs, n*sizeof(int64_t), HUNGARIAN_INT64,
+//                    row_to_col, NULL, NULL, &cost );
+//   hungarian_workspace_destroy( w );
+//
+// A workspace must not be used by two threads at the same time;
+// different workspaces are independent. The exception is
+// hungarian_cancel, which any thread may call to abandon the solve
+// running on a workspace (checked once per augmentation and per dual
+// update, or before and after the whole solve for the fixed engine,
+// which "auto" picks for n <= 64); hungarian_set_progress reports each
+// augmentation.
+//
+// A pool runs many solves on a fixed number of threads instead:
+// hungarian_submit queues one and returns at once, and its callback
+// (where an executor or a C++20 coroutine can be resumed) runs on the
+// pool thread that finished it. With slices, long solves are paused
+// every slice_ms and queued again, so short ones are not stuck behind
+// them. From C++, hungarian_submit_future returns a std::future:
+//
+//   hungarian_pool* p = hungarian_pool_create( 0, 2.0 );
+//   std::future<int> f = hungarian_submit_future( p, "auto", n, costs,
+//       n*sizeof(int64_t), HUNGARIAN_INT64, row_to_col, NULL, NULL, &cost );
+//   ...
+//   if ( f.get() == HUNGARIAN_OK ) ...
+//   hungarian_pool_destroy( p );
+//
+////////////////////////////////////////////////////////////////////////
+
+#ifndef HUNGARIAN_H
+#define HUNGARIAN_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define HUNGARIAN_API_VERSION 4      // 2: cancel and progress, 3: copy, 4: pool
+
+#if defined( __GNUC__ )
+#define HUNGARIAN_API __attribute__(( visibility( "default" ) ))
+#else
+#define HUNGARIAN_API
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// element types of the cost matrix
+enum hungarian_type {
+  HUNGARIAN_INT32 = 0,
+  HUNGARIAN_INT64 = 1
+};
+
+// return codes
+enum hungarian_status {
+  HUNGARIAN_OK = 0,
+  HUNGARIAN_EINVAL = -1,        // bad argument (n, stride, type, engine)
+  HUNGARIAN_ENOMEM = -2,
+  HUNGARIAN_EENGINE = -3,       // the engine cannot solve this n
+  HUNGARIAN_ECANCELLED = -4,    // hungarian_cancel was called
+  HUNGARIAN_EINTERNAL = -5      // unexpected failure inside the solver
+};
+
+typedef struct hungarian_workspace hungarian_workspace;
+
+// HUNGARIAN_API_VERSION of the library
+HUNGARIAN_API int hungarian_api_version( void );
+
+// NULL if out of memory
+HUNGARIAN_API hungarian_workspace* hungarian_workspace_create( void );
+HUNGARIAN_API void hungarian_workspace_destroy( hungarian_workspace* w );
+
+// "auto" (default), "fixed", "dense", "packed" or "pruned"
+HUNGARIAN_API int hungarian_set_engine( hungarian_workspace* w, const char* engine );
+
+// With copy != 0 each solve first copies the matrix into the workspace
+// (doubled int64, 8*n*n bytes), so that rows are not converted every
+// time the search reads them: faster, at the cost of the memory.
+// 0 (the default) reads the caller's rows in place.
+HUNGARIAN_API int hungarian_set_copy( hungarian_workspace* w, int copy );
+
+// Abandons the solve running on w (it returns HUNGARIAN_ECANCELLED),
+// or the next one if none is running. Thread safe, does not block.
+HUNGARIAN_API void hungarian_cancel( hungarian_workspace* w );
+
+// Called on the solving thread after each augmentation with the number
+// of matched rows and a lower bound on the optimal cost; NULL removes
+// it. The fixed engine (n <= 64) always runs to completion and does
+// not report progress.
+typedef void (*hungarian_progress_fn)( void* user, int matched, int n, int64_t lower_bound );
+HUNGARIAN_API int hungarian_set_progress( hungarian_workspace* w, hungarian_progress_fn fn, void* user );
+
+// Minimum cost assignment of the n x n matrix whose row v starts at
+// (const char*)costs + v*stride. Any of the outputs may be NULL:
+//   row_to_col[n]   column assigned to each row
+//   alpha[n], beta[n]   optimal duals, doubled so that they stay
+//                       integral (alpha[v]+beta[u] <= 2*c[v][u])
+//   cost            value of the assignment
+HUNGARIAN_API int hungarian_solve( hungarian_workspace* w, int n,
+				   const void* costs, size_t stride, int type,
+				   int32_t* row_to_col, int64_t* alpha,
+				   int64_t* beta, int64_t* cost );
+
+typedef struct hungarian_pool hungarian_pool;
+
+// threads workers (0: one per core) that run the dense engine in slices
+// of slice_ms milliseconds (0: every solve runs whole; with slices
+// "auto" picks dense above n = 64, the only engine that can pause).
+// NULL if out of memory or threads.
+HUNGARIAN_API hungarian_pool* hungarian_pool_create( int threads, double slice_ms );
+
+// Cancels the running and queued solves (their callbacks get
+// HUNGARIAN_ECANCELLED) and joins the workers.
+HUNGARIAN_API void hungarian_pool_destroy( hungarian_pool* p );
+
+// Called once per submitted solve, on a pool thread, after the outputs
+// are written; status as hungarian_solve would return it.
+typedef void (*hungarian_done_fn)( void* user, int status );
+
+// Queues the solve that hungarian_solve would do with this engine (NULL
+// is "auto"); the matrix and the outputs must stay valid until done is
+// called. Returns HUNGARIAN_OK, or HUNGARIAN_EINVAL / HUNGARIAN_ENOMEM
+// without queueing it (done is then not called).
+HUNGARIAN_API int hungarian_submit( hungarian_pool* p, const char* engine, int n,
+				    const void* costs, size_t stride, int type,
+				    int32_t* row_to_col, int64_t* alpha,
+				    int64_t* beta, int64_t* cost,
+				    hungarian_done_fn done, void* user );
+
+#ifdef __cplusplus
+}
+
+#include <future>
+
+// hungarian_submit with a future of the status instead of a callback
+inline std::future<int> hungarian_submit_future( hungarian_pool* p, const char* engine, int n,
+						 const void* costs, size_t stride, int type,
+						 int32_t* row_to_col, int64_t* alpha,
+						 int64_t* beta, int64_t* cost ) {
+  std::promise<int>* result = new std::promise<int>();
+  std::future<int> f = result->get_future();
+  int status = hungarian_submit( p, engine, n, costs, stride, type, row_to_col, alpha, beta, cost,
+				 []( void* user, int status ) {
+				   std::promise<int>* r = static_cast<std::promise<int>*>( user );
+				   r->set_value( status );
+				   delete r;
+				 }, result );
+  if ( status != HUNGARIAN_OK ) {
+    result->set_value( status );
+    delete result;
+  }
+  return f;
+}
+#endif
+
+#endif
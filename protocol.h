@@ -0,0 +1,46 @@
+////////////////////////////////////////////////////////////////////////
+//
+// Wire format of "hungarian --serve <socket>" (Unix domain stream
+// socket, integers in host byte order)
+//
+// request:  uint32 size      number of bytes that follow
+//           uint32 id        echoed in the response
+//           uint32 flags     engine index (see serve_engines) | SERVE_DUALS
+//           int32  N
+//           int64  c[N][N]   row-major
+//
+// response: uint32 size      number of bytes that follow
+//           uint32 id
+//           int32  status    SERVE_OK or an error code
+//           int32  N         0 unless status == SERVE_OK
+//           int64  cost
+//           int32  mate[N]   column assigned to each row
+//           int64  alpha[N], beta[N]   only with SERVE_DUALS, doubled
+//
+// A connection may pipeline any number of requests; responses come
+// back as soon as they are solved, so they are matched by id.
+//
+////////////////////////////////////////////////////////////////////////
+
+#ifndef HUNGARIAN_PROTOCOL_H
+#define HUNGARIAN_PROTOCOL_H
+
+#include <cstdint>
+#include <cstddef>
+
+// the engine index is in bits 0-2 of flags
+const uint32_t SERVE_ENGINE_MASK = 7;
+const char* const serve_engines[] = { "auto", "fixed", "dense", "packed", "pruned" };
+const uint32_t SERVE_ENGINES = sizeof( serve_engines )/sizeof( serve_engines[0] );
+const uint32_t SERVE_DUALS = 8;
+
+const int32_t SERVE_OK = 0;
+const int32_t SERVE_EBADREQUEST = 1;   // malformed N, size or engine
+const int32_t SERVE_EENGINE = 2;       // engine cannot solve this N
+
+const int32_t SERVE_MAX_N = 16384;
+
+const size_t SERVE_REQUEST_HEADER = 16;  // size, id, flags, N
+const size_t SERVE_RESPONSE_HEADER = 24; // size, id, status, N, cost
+
+#endif